@@ -0,0 +1,140 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : bench
+ * @created     : Friday Oct 16, 2026 22:41:19 CEST
+ * @description : Minimal harness to time functions and count their allocations
+ * */
+
+#ifndef BENCH_BENCH_HPP
+#define BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+namespace brun::bench
+{
+
+/**
+ * Incremented by the replacement of `operator new` of the benchmark executable
+ * */
+struct allocation_counters
+{
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+};
+
+inline auto allocations = allocation_counters{};
+
+/**
+ * Prevents the compiler from optimizing away the computation of `value`
+ * */
+template <typename T>
+inline
+void do_not_optimize(T const & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct result
+{
+    std::string name;
+    std::string fixture;
+    std::size_t containers;
+    std::size_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+};
+
+struct options
+{
+    std::chrono::milliseconds min_time{200};
+    std::string filter;
+};
+
+/**
+ * Runs `function` repeatedly, doubling the number of iterations until the whole run lasts at
+ * least `min_time`, and reports the average time and allocations of one call.
+ *
+ * \param opts The options of the run
+ * \param name The name of the benchmark
+ * \param fx_name The name of the fixture it runs on
+ * \param containers The number of containers of the fixture
+ * \param function The function to be timed; its result is kept alive
+ * \returns The result, or nothing if the benchmark was filtered out
+ * */
+template <typename Function>
+auto run(options const & opts, std::string_view name, std::string_view fx_name, std::size_t containers,
+         Function && function)
+    -> std::vector<result>
+{
+    auto const full_name = fmt::format("{}/{}", name, fx_name);
+    if (not opts.filter.empty() and full_name.find(opts.filter) == std::string::npos) {
+        return {};
+    }
+
+    using clock = std::chrono::steady_clock;
+    do_not_optimize(function());  // warm up
+
+    for (auto iterations = std::size_t{1}; ; iterations *= 2) {
+        auto const before = allocations;
+        auto const start = clock::now();
+        for (auto i = std::size_t{0}; i < iterations; ++i) {
+            do_not_optimize(function());
+        }
+        auto const elapsed = clock::now() - start;
+        auto const after = allocations;
+        if (elapsed >= opts.min_time or iterations >= (std::size_t{1} << 30)) {
+            auto const n = static_cast<double>(iterations);
+            auto const ns = std::chrono::duration<double, std::nano>{elapsed}.count();
+            return {{
+                std::string{name},
+                std::string{fx_name},
+                containers,
+                iterations,
+                ns / n,
+                static_cast<double>(after.count - before.count) / n,
+                static_cast<double>(after.bytes - before.bytes) / n,
+            }};
+        }
+    }
+}
+
+inline
+void print_table(std::vector<result> const & results)
+{
+    fmt::print("{:<36} {:<20} {:>14} {:>14} {:>14}\n", "benchmark", "fixture", "ns/op", "allocs/op", "bytes/op");
+    for (auto const & r : results) {
+        fmt::print("{:<36} {:<20} {:>14.1f} {:>14.1f} {:>14.1f}\n",
+            r.name, r.fixture, r.ns_per_op, r.allocs_per_op, r.bytes_per_op
+        );
+    }
+}
+
+/**
+ * Writes the results as a JSON array, to be compared with the ones of another build
+ * */
+inline
+void write_json(std::FILE * out, std::vector<result> const & results)
+{
+    fmt::print(out, "[\n");
+    for (auto i = std::size_t{0}; i < results.size(); ++i) {
+        auto const & r = results[i];
+        fmt::print(out,
+            R"(  {{"name": "{}", "fixture": "{}", "containers": {}, "iterations": {}, )"
+            R"("ns_per_op": {:.3f}, "allocs_per_op": {:.3f}, "bytes_per_op": {:.3f}}}{})" "\n",
+            r.name, r.fixture, r.containers, r.iterations, r.ns_per_op, r.allocs_per_op, r.bytes_per_op,
+            i + 1 < results.size() ? "," : ""
+        );
+    }
+    fmt::print(out, "]\n");
+}
+
+} // namespace brun::bench
+
+#endif /* BENCH_BENCH_HPP */
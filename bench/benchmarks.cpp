@@ -0,0 +1,372 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : benchmarks
+ * @created     : Friday Oct 16, 2026 23:02:51 CEST
+ * @description : times the functions working on the i3 state, on recorded and generated fixtures
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+
+#include "bench.hpp"
+#include "fixtures.hpp"
+
+#include "context.hpp"
+#include "detail/i3_json.hpp"
+#include "focus_path.hpp"
+#include "lazy_tree.hpp"
+#include "marks.hpp"
+#include "nodes.hpp"
+#include "output_topology.hpp"
+#include "outputs.hpp"
+#include "placement_queue.hpp"
+#include "shared_state.hpp"
+#include "snapshot.hpp"
+#include "tree_diff.hpp"
+#include "tree_range.hpp"
+#include "workspace_extra.hpp"
+#include "workspace_history.hpp"
+#include "workspace_index.hpp"
+#include "workspace_plan.hpp"
+#include "workspaces.hpp"
+
+#ifndef BENCH_FIXTURES_DIR
+#define BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+
+// Count every allocation, so that the benchmarks can report them
+[[gnu::noinline]]
+void * operator new(std::size_t size)
+{
+    ++brun::bench::allocations.count;
+    brun::bench::allocations.bytes += size;
+    if (auto * ptr = std::malloc(size != 0 ? size : 1); ptr != nullptr) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+// The arenas of `std::pmr` ask for aligned memory
+void * operator new(std::size_t size, std::align_val_t align)
+{
+    ++brun::bench::allocations.count;
+    brun::bench::allocations.bytes += size;
+    auto const alignment = static_cast<std::size_t>(align);
+    if (auto * ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment); ptr != nullptr) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+// GCC cannot see that the memory was returned by the `operator new` above
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+#pragma GCC diagnostic pop
+
+namespace
+{
+using brun::bench::fixture;
+using brun::bench::result;
+
+/// The last mark found in the tree, so that the searches walk most of it
+auto last_mark(i3_containers::node const & node)
+    -> tl::optional<std::string>
+{
+    auto found = tl::optional<std::string>{};
+    for (auto const & container : brun::preorder(node)) {
+        if (not container.marks.empty()) {
+            found = container.marks.back();
+        }
+    }
+    return found;
+}
+
+/// The first container with more than one tiling child, depth first
+auto split_container(i3_containers::node & node)
+    -> i3_containers::node *
+{
+    if (node.nodes.size() > 1) {
+        return &node;
+    }
+    for (auto & child : node.nodes) {
+        if (auto * found = split_container(child); found != nullptr) {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+/// A copy of the tree with a few changes in one container: its first two children swapped, its
+///  layout, a mark and a rect of a child
+auto changed_copy(i3_containers::node tree)
+    -> i3_containers::node
+{
+    if (auto * split = split_container(tree); split != nullptr) {
+        std::swap(split->nodes[0], split->nodes[1]);
+        split->layout = split->layout == i3_containers::node_layout::tabbed
+            ? i3_containers::node_layout::splith
+            : i3_containers::node_layout::tabbed;
+        split->nodes[0].marks.emplace_back("bench_diff");
+        split->nodes[1].rect.width += 10;
+    }
+    return tree;
+}
+
+void run_all(brun::bench::options const & opts, fixture const & fx, std::vector<result> & results)
+{
+    auto const add = [&](std::string_view name, auto && function) {
+        auto r = brun::bench::run(opts, name, fx.name, fx.containers, function);
+        results.insert(results.end(), r.begin(), r.end());
+    };
+    auto const parse_tree = [&fx] {
+        auto json = brun::json::reader{fx.tree};
+        return brun::json::read_node(json);
+    };
+    auto const parse_workspaces = [&fx] {
+        auto json = brun::json::reader{fx.workspaces};
+        return brun::json::read_workspaces(json);
+    };
+    auto const parse_outputs = [&fx] {
+        auto json = brun::json::reader{fx.outputs};
+        return brun::json::read_outputs(json);
+    };
+
+    auto const tree = parse_tree();
+    auto const workspaces = parse_workspaces();
+    auto const outputs = parse_outputs();
+    auto const flat = brun::snapshot{tree};
+    auto const marks = brun::mark_index{tree};
+
+    // Parsing
+    add("parse/tree", parse_tree);
+    add("parse/focus_chain", [&fx] { return brun::decode_focus_chain(fx.tree); });
+    add("parse/workspaces", parse_workspaces);
+    add("parse/outputs", parse_outputs);
+    add("snapshot/build", [&tree] { return brun::snapshot{tree}; });
+    // GET_TREE to snapshot: through the tree, as before, or directly into the arena
+    add("snapshot/parse_and_build", [&parse_tree] { return brun::snapshot{parse_tree()}; });
+    add("snapshot/decode", [&fx] { return brun::snapshot::decode(fx.tree); });
+    add("mark_index/build", [&tree] { return brun::mark_index{tree}; });
+
+    // Comparing two snapshots, as the verification mode of the daemon does after each event
+    auto const same = brun::snapshot{tree};
+    auto const changed = brun::snapshot{changed_copy(tree)};
+    add("tree_diff/same", [&flat, &same] { return brun::diff(flat, same); });
+    add("tree_diff/changed", [&flat, &changed] { return brun::diff(flat, changed); });
+
+    // Traversal
+    add("tree_range/preorder", [&tree] { return std::ranges::distance(brun::preorder(tree)); });
+    add("tree_range/postorder", [&tree] { return std::ranges::distance(brun::postorder(tree)); });
+    add("tree_range/breadth_first", [&tree] { return std::ranges::distance(brun::breadth_first(tree)); });
+
+    // Focus
+    add("focused_node/tree", [&tree] { return brun::focused_node(tree); });
+    add("focused_node/snapshot", [&flat] { return brun::focused_node(flat); });
+    add("node_on_border/tree", [&tree] { return brun::node_on_border(tree); });
+    add("node_on_border/snapshot", [&flat] { return brun::node_on_border(flat); });
+    add("analyze_focus/tree", [&tree] { return brun::analyze_focus(tree); });
+
+    // Marks
+    if (auto const mark = last_mark(tree); mark.has_value()) {
+        add("find_ws_by_mark/tree", [&tree, &mark] { return brun::find_ws_by_mark(tree, *mark); });
+        add("find_ws_by_mark/snapshot", [&flat, &mark] { return brun::find_ws_by_mark(flat, *mark); });
+        add("mark_index/find", [&marks, &mark] { return marks.find(*mark); });
+    }
+
+    // Workspaces
+    if (not workspaces.empty()) {
+        auto const id = workspaces.back().id;
+        add("get_workspace_node/tree", [&tree, id] { return brun::get_workspace_node(tree, id); });
+        add("get_workspace_node/snapshot", [&flat, id] { return brun::get_workspace_node(flat, id); });
+    }
+
+    // Outputs
+    auto outputs_ctx = brun::context{};
+    outputs_ctx.set_outputs(outputs);
+    add("retrieve_output_names", [&outputs_ctx] { return brun::retrieve_output_names(outputs_ctx); });
+
+    add("output_topology/build", [&outputs] { return brun::output_topology{outputs}; });
+    auto const topology = brun::output_topology{outputs};
+    if (not topology.empty()) {
+        add("output_topology/neighbor", [&topology] { return topology.neighbor(0, brun::direction::right); });
+    }
+
+    // State published by the daemon: the cost of publishing it, and of reading it instead of the replies
+    add("shared_state/encode", [&tree, &marks, &topology] {
+        auto out = brun::shared_state::detail::state_writer{};
+        brun::shared_state::detail::encode(out, tree, marks, topology);
+        return out.words();
+    });
+    auto published = brun::shared_state::detail::state_writer{};
+    brun::shared_state::detail::encode(published, tree, marks, topology);
+    add("shared_state/decode", [&published] { return brun::shared_state::detail::decode(published.bytes()); });
+    auto const max_ws = topology.max_workspace();
+    add("plan_workspaces", [&workspaces, &topology] { return brun::plan_workspaces(workspaces, topology); });
+    auto ws_ctx = brun::context{};
+    ws_ctx.set_workspaces(workspaces);
+    add("fix_ws_number", [&ws_ctx, &topology, max_ws] {
+        auto const fixed = brun::fix_ws_number(ws_ctx, max_ws + 5, topology);
+        ws_ctx.take_recorded_commands();
+        return fixed;
+    });
+
+    // Workspace index
+    add("workspace_index/build", [&workspaces] { return brun::workspace_index{workspaces}; });
+    auto const index = brun::workspace_index{workspaces};
+    if (not workspaces.empty()) {
+        auto const num = workspaces.back().num.value_or(1);
+        auto const id = workspaces.back().id;
+        add("workspace_index/find", [&index, num] { return index.find(num).has_value(); });
+        add("workspace_index/find_id", [&index, id] { return index.find_id(id).has_value(); });
+        add("workspace_output", [&ws_ctx, num] { return brun::workspace_output(ws_ctx, num); });
+    }
+    // Workspace history
+    if (workspaces.size() >= 2) {
+        auto const focus_event = [&workspaces](std::size_t i) {
+            return fmt::format(R"({{"change":"focus","current":{{"id":{},"name":"{}","output":"{}"}},"old":null}})",
+                               workspaces[i].id, workspaces[i].name, workspaces[i].output);
+        };
+        add("workspace_history/apply", [history = brun::workspace_history{workspaces},
+                                         events = std::array{focus_event(0), focus_event(1)}, i = 0u]() mutable {
+            return history.apply(events[i++ % 2]);
+        });
+    }
+    add("workspace_index/nearest_free", [&index, max_ws] { return index.nearest_free(max_ws - 5, max_ws); });
+}
+
+/**
+ * Matches the windows of a launch storm with their launches, the windows appearing in the reverse
+ * order of the launches
+ * */
+void run_placement(brun::bench::options const & opts, std::size_t launches, std::vector<result> & results)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::hours{1};
+    auto pending = std::vector<brun::launch>{};
+    auto windows = std::vector<brun::window_identity>{};
+    for (auto i = std::size_t{0}; i < launches; ++i) {
+        auto program = fmt::format("program-{}", i);
+        windows.push_back({launches - i, program, program});
+        pending.push_back({std::move(program), false, 1, i3_containers::node_layout::splith, true, "1", deadline});
+    }
+    std::ranges::reverse(windows);
+
+    auto const match_all = [&pending, &windows] {
+        auto queue = brun::placement_queue{};
+        for (auto const & l : pending) {
+            queue.push(l);
+        }
+        auto batch = brun::command_batch{};
+        for (auto const & window : windows) {
+            if (auto const matched = queue.match(window); matched.has_value()) {
+                brun::place(batch, *matched, window.id);
+            }
+        }
+        return batch;
+    };
+    auto const batch = match_all();
+    if (batch.size() != 2 * launches) {
+        fmt::print(stderr, "placement: {} commands for {} launches\n", batch.size(), launches);
+    }
+    auto r = brun::bench::run(opts, "placement/match", "storm", launches, match_all);
+    results.insert(results.end(), r.begin(), r.end());
+}
+
+void usage(char const * name)
+{
+    fmt::print(stderr,
+        "Usage: {} [--filter <text>] [--min-time <ms>] [--json <file>] [--fixtures <dir>] [--sizes <n,...>]\n",
+        name
+    );
+}
+} // namespace
+
+int main(int argc, char const * argv[])
+try {
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    auto opts = brun::bench::options{};
+    auto json_path = std::string{};
+    auto fixtures_dir = std::string{BENCH_FIXTURES_DIR};
+    auto sizes = std::vector<std::size_t>{10, 100, 1'000, 10'000};
+
+    for (auto i = std::size_t{1}; i < args.size(); ++i) {
+        auto const arg = std::string_view{args[i]};
+        if (i + 1 == args.size()) {
+            usage(args[0]);
+            return 1;
+        }
+        auto const value = std::string{args[++i]};
+        if (arg == "--filter") {
+            opts.filter = value;
+        }
+        else if (arg == "--min-time") {
+            opts.min_time = std::chrono::milliseconds{brun::stoi(value).value_or(200)};
+        }
+        else if (arg == "--json") {
+            json_path = value;
+        }
+        else if (arg == "--fixtures") {
+            fixtures_dir = value;
+        }
+        else if (arg == "--sizes") {
+            sizes.clear();
+            for (auto const part : std::views::split(value, ',')) {
+                sizes.push_back(static_cast<std::size_t>(brun::stoi(std::string_view{part.begin(), part.end()}).value_or(0)));
+            }
+        }
+        else {
+            usage(args[0]);
+            return 1;
+        }
+    }
+
+    auto fixtures = std::vector<fixture>{};
+    if (std::filesystem::is_directory(fixtures_dir)) {
+        auto directories = std::vector<std::filesystem::path>{};
+        for (auto const & entry : std::filesystem::directory_iterator{fixtures_dir}) {
+            if (entry.is_directory()) {
+                directories.push_back(entry.path());
+            }
+        }
+        std::ranges::sort(directories);
+        for (auto const & directory : directories) {
+            fixtures.push_back(brun::bench::load_fixture(directory.string(), directory.filename().string()));
+        }
+    }
+    else {
+        fmt::print(stderr, "No recorded fixtures in {}\n", fixtures_dir);
+    }
+    for (auto const size : sizes) {
+        fixtures.push_back(brun::bench::synthetic_fixture(size));
+    }
+
+    auto results = std::vector<result>{};
+    for (auto const & fx : fixtures) {
+        run_all(opts, fx, results);
+    }
+    run_placement(opts, 50, results);
+
+    brun::bench::print_table(results);
+    if (not json_path.empty()) {
+        auto * out = std::fopen(json_path.c_str(), "w");
+        if (out == nullptr) {
+            fmt::print(stderr, "Cannot write {}\n", json_path);
+            return 1;
+        }
+        brun::bench::write_json(out, results);
+        std::fclose(out);
+    }
+}
+catch (std::exception const & exc) {
+    fmt::print(stderr, "{}\n", exc.what());
+    return 1;
+}
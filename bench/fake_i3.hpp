@@ -0,0 +1,470 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : fake_i3
+ * @created     : Friday Oct 16, 2026 23:48:06 CEST
+ * @description : Stand-in for i3 which serves a fixture on a Unix socket and records the commands
+ * */
+
+#ifndef BENCH_FAKE_I3_HPP
+#define BENCH_FAKE_I3_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "command_batch.hpp"
+#include "detail/i3_json.hpp"
+#include "detail/json.hpp"
+#include "detail/unique_fd.hpp"
+#include "ipc.hpp"
+
+#include "fixtures.hpp"
+
+namespace brun::bench
+{
+
+/**
+ * What the fake i3 received since it was started, or since the last `take_log`
+ * */
+struct fake_i3_log
+{
+    std::size_t connections = 0;
+    std::size_t requests = 0;                           // every message, commands included
+    std::map<ipc::message_type, std::size_t> by_type;
+    std::vector<std::string> commands;                  // the payloads of RUN_COMMAND, in order
+};
+
+namespace detail
+{
+/// The marks of the tree, in the order of GET_MARKS
+[[nodiscard]] inline
+auto collect_marks(std::string_view tree)
+    -> std::vector<std::string>
+{
+    auto json = json::reader{tree};
+    auto const root = json::read_node(json);
+    auto marks = std::vector<std::string>{};
+    auto const visit = [&marks](auto const & self, i3_containers::node const & node) -> void {
+        marks.insert(marks.end(), node.marks.begin(), node.marks.end());
+        for (auto const * children : {&node.nodes, &node.floating_nodes}) {
+            for (auto const & child : *children) {
+                self(self, child);
+            }
+        }
+    };
+    visit(visit, root);
+    return marks;
+}
+
+/// Writes `[{"success":true}, ...]` with one entry for each command of `payload`
+[[nodiscard]] inline
+auto command_reply(std::string_view payload)
+    -> std::string
+{
+    auto const count = std::max<std::size_t>(brun::detail::count_commands(payload), 1);
+    auto reply = std::string{"["};
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        reply += i == 0 ? R"({"success":true})" : R"(,{"success":true})";
+    }
+    reply += ']';
+    return reply;
+}
+
+/// The programs run by the `exec` commands of `payload`, e.g. `firefox` for `exec --no-startup-id firefox -P x`
+[[nodiscard]] inline
+auto executed_programs(std::string_view payload)
+    -> std::vector<std::string>
+{
+    auto programs = std::vector<std::string>{};
+    for (auto pos = payload.find("exec "); pos != std::string_view::npos; pos = payload.find("exec ", pos + 1)) {
+        auto rest = payload.substr(pos + 5);
+        if (rest.starts_with("--no-startup-id ")) {
+            rest.remove_prefix(16);
+        }
+        auto program = rest.substr(0, rest.find_first_of(" ;,"));
+        program = program.substr(program.rfind('/') + 1);
+        programs.emplace_back(program.empty() ? "fake" : program);
+    }
+    return programs;
+}
+
+/// The `new` window event which follows an `exec` command, for a window of class `program`
+[[nodiscard]] inline
+auto new_window_event(std::uint64_t id, std::string_view program)
+    -> std::string
+{
+    auto container = std::string{};
+    auto out = tree_writer{container};
+    out.open(id, "con", program, "splith", {0, 0, 800, 600}, true, "fake", {}, true, program);
+    out.begin_nodes();
+    out.begin_floating_nodes();
+    out.close({});
+    return fmt::format(R"({{"change":"new","container":{}}})", container);
+}
+} // namespace detail
+
+
+/**
+ * Speaks the i3 IPC protocol on a Unix socket, serving the replies of a fixture.
+ *
+ * GET_TREE, GET_WORKSPACES, GET_OUTPUTS, GET_MARKS and GET_VERSION are answered with the canned
+ * replies; RUN_COMMAND is recorded and answered with a success for each command, without changing
+ * the state, so that every run of a tool sees the same one. Clients subscribed to window events
+ * receive a `new` event for each program run by `exec`, like the ones waited by `exec`: each
+ * window has its own id and the name of the program as class, and can appear after a random delay
+ * (see `delay_windows`), as real programs do. SEND_TICK is sent back to the clients subscribed to
+ * tick events.
+ *
+ * Each request can be delayed, per type, to model a busy i3. The server runs on its own thread
+ * from construction to destruction.
+ * */
+class fake_i3
+{
+private:
+    struct client
+    {
+        brun::detail::unique_fd socket;
+        bool window_events = false;
+        bool tick_events = false;
+    };
+
+    struct pending_window
+    {
+        std::chrono::steady_clock::time_point due;
+        std::string event;
+    };
+
+    std::string _path;
+    fixture _fixture;
+    std::string _marks;
+    std::map<ipc::message_type, std::chrono::microseconds> _delays;
+
+    brun::detail::unique_fd _listener;
+    brun::detail::unique_fd _stop;  // eventfd, written to stop the thread
+    std::vector<client> _clients;
+    std::vector<pending_window> _windows;       // only touched by the thread of the server
+    std::uint64_t _next_window = 0x5'0000'0000;
+    std::uint64_t _random = 0x2545'f491'4f6c'dd1d;
+    std::chrono::microseconds _max_window_delay{0};
+
+    mutable std::mutex _mutex;
+    fake_i3_log _log;
+    std::thread _thread;
+
+    void record(ipc::message_type type, std::string_view payload)
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        ++_log.requests;
+        ++_log.by_type[type];
+        if (type == ipc::message_type::run_command) {
+            _log.commands.emplace_back(payload);
+        }
+    }
+
+    static void send(int fd, std::uint32_t type, std::string_view payload)
+    {
+        auto const header = ipc::detail::encode_header(type, payload.size());
+        ipc::detail::write_all(fd, {header.data(), header.size()}, payload);
+    }
+
+    /**
+     * Reads a request from the client and answers it
+     *
+     * \returns `false` if the client disconnected
+     * */
+    bool serve(client & c)
+    {
+        auto header = std::array<char, ipc::header_size>{};
+        auto const received = ::recv(c.socket.get(), header.data(), header.size(), MSG_WAITALL);
+        if (received <= 0) {
+            return false;
+        }
+        if (static_cast<std::size_t>(received) != header.size()) {
+            throw ipc::bad_message{"truncated header"};
+        }
+        auto const [length, raw_type] = ipc::detail::decode_header(header);
+        auto payload = std::string(length, '\0');
+        ipc::detail::read_all(c.socket.get(), payload.data(), length);
+
+        auto const type = static_cast<ipc::message_type>(raw_type);
+        record(type, payload);
+        if (auto const delay = _delays.find(type); delay != _delays.end()) {
+            std::this_thread::sleep_for(delay->second);
+        }
+
+        using enum ipc::message_type;
+        switch (type) {
+        case get_tree:       send(c.socket.get(), raw_type, _fixture.tree); break;
+        case get_workspaces: send(c.socket.get(), raw_type, _fixture.workspaces); break;
+        case get_outputs:    send(c.socket.get(), raw_type, _fixture.outputs); break;
+        case get_marks:      send(c.socket.get(), raw_type, _marks); break;
+        case get_version:
+            send(c.socket.get(), raw_type,
+                 R"({"major":4,"minor":22,"patch":0,"human_readable":"4.22-fake","loaded_config_file_name":""})");
+            break;
+        case subscribe:
+            c.window_events = c.window_events or payload.find("\"window\"") != std::string::npos;
+            c.tick_events = c.tick_events or payload.find("\"tick\"") != std::string::npos;
+            send(c.socket.get(), raw_type, R"({"success":true})");
+            break;
+        case run_command:
+            send(c.socket.get(), raw_type, detail::command_reply(payload));
+            for (auto const & program : detail::executed_programs(payload)) {
+                _next_window += 0x130;
+                _windows.push_back({std::chrono::steady_clock::now() + window_delay(),
+                                    detail::new_window_event(_next_window, program)});
+            }
+            send_due_windows();
+            break;
+        case send_tick:
+            send(c.socket.get(), raw_type, R"({"success":true})");
+            send_tick_event(payload);
+            break;
+        case sync:
+            send(c.socket.get(), raw_type, R"({"success":true})");
+            break;
+        default:
+            send(c.socket.get(), raw_type, R"({"success":false,"error":"not supported by the fake i3"})");
+            break;
+        }
+        return true;
+    }
+
+    /// Sends a tick with `payload` to the subscribed clients, after the events sent so far
+    void send_tick_event(std::string_view payload)
+    {
+        auto event = std::string{R"({"first":false,"payload":")"};
+        for (auto const ch : payload) {
+            if (ch == '"' or ch == '\\') {
+                event += '\\';
+            }
+            event += ch;
+        }
+        event += "\"}";
+        auto const event_type = ipc::event_bit | static_cast<std::uint32_t>(ipc::event_type::tick);
+        for (auto const & c : _clients) {
+            try {
+                if (c.tick_events) {
+                    send(c.socket.get(), event_type, event);
+                }
+            }
+            catch (std::exception const &) {
+                // the client is gone, and is dropped when its socket is polled
+            }
+        }
+    }
+
+    /// A random delay between 0 and the maximum set with `delay_windows`
+    auto window_delay()
+        -> std::chrono::microseconds
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        if (_max_window_delay.count() == 0) {
+            return {};
+        }
+        // xorshift64: the same sequence on every run
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+        return std::chrono::microseconds{static_cast<std::int64_t>(_random % static_cast<std::uint64_t>(_max_window_delay.count() + 1))};
+    }
+
+    /// Sends the window events whose time has come to the subscribed clients
+    void send_due_windows()
+    {
+        auto const now = std::chrono::steady_clock::now();
+        auto const event_type = ipc::event_bit | static_cast<std::uint32_t>(ipc::event_type::window);
+        std::ranges::stable_sort(_windows, {}, &pending_window::due);
+        auto const due = std::ranges::find_if(_windows, [now](auto const & w) { return w.due > now; });
+        for (auto window = _windows.begin(); window != due; ++window) {
+            for (auto const & c : _clients) {
+                try {
+                    if (c.window_events) {
+                        send(c.socket.get(), event_type, window->event);
+                    }
+                }
+                catch (std::exception const &) {
+                    // the client is gone, and is dropped when its socket is polled
+                }
+            }
+        }
+        _windows.erase(_windows.begin(), due);
+    }
+
+    /// Milliseconds until the next window is due, or -1 to wait forever
+    [[nodiscard]]
+    int poll_timeout() const
+    {
+        if (_windows.empty()) {
+            return -1;
+        }
+        auto const next = std::ranges::min(_windows, {}, &pending_window::due).due;
+        auto const left = std::chrono::ceil<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<std::int64_t>(left.count(), 0));
+    }
+
+    void loop()
+    {
+        auto fds = std::vector<pollfd>{};
+        while (true) {
+            fds.clear();
+            fds.push_back({_stop.get(), POLLIN, 0});
+            fds.push_back({_listener.get(), POLLIN, 0});
+            for (auto const & c : _clients) {
+                fds.push_back({c.socket.get(), POLLIN, 0});
+            }
+            if (::poll(fds.data(), fds.size(), poll_timeout()) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::generic_category(), "poll"};
+            }
+            if (fds[0].revents != 0) {
+                return;
+            }
+            send_due_windows();
+
+            // Serve the clients before accepting new ones, since the indices of `fds` follow `_clients`
+            auto closed = std::vector<std::size_t>{};
+            for (auto i = std::size_t{0}; i < _clients.size(); ++i) {
+                auto const revents = fds[i + 2].revents;
+                if (revents == 0) {
+                    continue;
+                }
+                auto keep = (revents & POLLIN) != 0;
+                try {
+                    keep = keep and serve(_clients[i]);
+                }
+                catch (std::exception const & exc) {
+                    fmt::print(stderr, "fake i3: dropping a client: {}\n", exc.what());
+                    keep = false;
+                }
+                if (not keep) {
+                    closed.push_back(i);
+                }
+            }
+            for (auto i = closed.rbegin(); i != closed.rend(); ++i) {
+                _clients.erase(_clients.begin() + static_cast<std::ptrdiff_t>(*i));
+            }
+
+            if ((fds[1].revents & POLLIN) != 0) {
+                auto socket = brun::detail::unique_fd{::accept4(_listener.get(), nullptr, nullptr, SOCK_CLOEXEC)};
+                if (socket) {
+                    _clients.push_back({std::move(socket)});
+                    auto const lock = std::scoped_lock{_mutex};
+                    ++_log.connections;
+                }
+            }
+        }
+    }
+
+public:
+    /**
+     * Starts serving `fx` on `path`, replacing any socket already there
+     *
+     * \param path The path of the socket, to be exported as `I3SOCK`
+     * \param fx The replies to serve
+     * \param delays How long to wait before answering each type of request
+     * */
+    fake_i3(std::string path, fixture fx, std::map<ipc::message_type, std::chrono::microseconds> delays = {})
+        : _path{std::move(path)}
+        , _fixture{std::move(fx)}
+        , _delays{std::move(delays)}
+    {
+        auto const marks = detail::collect_marks(_fixture.tree);
+        _marks = '[';
+        for (auto const & mark : marks) {
+            _marks += fmt::format("{}\"{}\"", _marks.size() > 1 ? "," : "", mark);
+        }
+        _marks += ']';
+
+        auto address = sockaddr_un{};
+        address.sun_family = AF_UNIX;
+        if (_path.size() >= sizeof(address.sun_path)) {
+            throw std::system_error{ENAMETOOLONG, std::generic_category(), "fake i3 socket path"};
+        }
+        std::memcpy(address.sun_path, _path.data(), _path.size());
+        ::unlink(_path.c_str());
+        _listener.reset(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (not _listener
+                or ::bind(_listener.get(), reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0
+                or ::listen(_listener.get(), 64) != 0) {
+            throw std::system_error{errno, std::generic_category(), fmt::format("listen on {}", _path)};
+        }
+        _stop.reset(::eventfd(0, EFD_CLOEXEC));
+        if (not _stop) {
+            throw std::system_error{errno, std::generic_category(), "eventfd"};
+        }
+        _thread = std::thread{[this] {
+            try {
+                loop();
+            }
+            catch (std::exception const & exc) {
+                fmt::print(stderr, "fake i3 stopped: {}\n", exc.what());
+            }
+        }};
+    }
+
+    fake_i3(fake_i3 const &) = delete;
+    fake_i3 & operator=(fake_i3 const &) = delete;
+
+    ~fake_i3()
+    {
+        auto const one = std::uint64_t{1};
+        [[maybe_unused]] auto const written = ::write(_stop.get(), &one, sizeof(one));
+        _thread.join();
+        ::unlink(_path.c_str());
+    }
+
+    [[nodiscard]] auto const & path() const noexcept { return _path; }
+
+    /**
+     * Makes the windows of the next `exec` commands appear after a random delay up to `max`, so
+     * that they can come in a different order than the commands
+     * */
+    void delay_windows(std::chrono::microseconds max)
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        _max_window_delay = max;
+    }
+
+    /// A copy of what was received so far
+    [[nodiscard]]
+    auto log() const
+        -> fake_i3_log
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        return _log;
+    }
+
+    /// Moves out what was received so far, starting a new log
+    auto take_log()
+        -> fake_i3_log
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        return std::exchange(_log, {});
+    }
+};
+
+} // namespace brun::bench
+
+#endif /* BENCH_FAKE_I3_HPP */
@@ -0,0 +1,300 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : fixtures
+ * @created     : Friday Oct 16, 2026 22:10:37 CEST
+ * @description : Replies of i3 used by the benchmarks, recorded or generated
+ * */
+
+#ifndef BENCH_FIXTURES_HPP
+#define BENCH_FIXTURES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+namespace brun::bench
+{
+
+/**
+ * The replies to GET_TREE, GET_WORKSPACES and GET_OUTPUTS describing the same state
+ * */
+struct fixture
+{
+    std::string name;
+    std::size_t containers;
+    std::string tree;
+    std::string workspaces;
+    std::string outputs;
+};
+
+namespace detail
+{
+inline
+auto read_file(std::string const & path)
+    -> std::string
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (not file) {
+        throw std::runtime_error{fmt::format("cannot open fixture {}", path)};
+    }
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+/**
+ * Writes containers in the same form, and with the same fields, used by i3 4.22
+ * */
+class tree_writer
+{
+private:
+    std::string & _out;
+    uint64_t _next_id = 94'358'391'820'000;
+
+public:
+    struct rect { int x, y, width, height; };
+
+    explicit tree_writer(std::string & out) : _out{out} {}
+
+    auto next_id() noexcept { return _next_id += 0x130; }
+
+    /// Writes all the fields of a container but `nodes`, `floating_nodes` and `focus`
+    void open(uint64_t id, std::string_view type, std::string_view name, std::string_view layout,
+              rect r, bool focused, std::string_view output, std::vector<std::string> const & marks = {},
+              bool window = false, std::string_view window_class = "Alacritty")
+    {
+        fmt::format_to(std::back_inserter(_out),
+            R"({{"id":{},"type":"{}","orientation":"{}","scratchpad_state":"none","percent":{},"urgent":false,)"
+            R"("marks":[{}],"focused":{},"output":"{}","layout":"{}","workspace_layout":"default",)"
+            R"("last_split_layout":"splith","border":"{}","current_border_width":{},)"
+            R"("rect":{{"x":{},"y":{},"width":{},"height":{}}},"deco_rect":{{"x":0,"y":0,"width":0,"height":0}},)"
+            R"("window_rect":{{"x":{},"y":{},"width":{},"height":{}}},"geometry":{{"x":0,"y":0,"width":{},"height":{}}},)"
+            R"("name":"{}",)",
+            id, type, layout == "splitv" ? "vertical" : layout == "splith" ? "horizontal" : "none",
+            window ? "0.25" : "null",
+            fmt::join(marks | std::views::transform([](auto const & m) { return fmt::format("\"{}\"", m); }), ","),
+            focused, output, layout, window ? "pixel" : "normal", window ? 2 : -1,
+            r.x, r.y, r.width, r.height,
+            window ? 2 : 0, window ? 2 : 0, window ? r.width - 4 : 0, window ? r.height - 4 : 0,
+            r.width, r.height, name
+        );
+        if (window) {
+            fmt::format_to(std::back_inserter(_out),
+                R"("window":{},"window_type":"normal","window_properties":{{"class":"{}",)"
+                R"("instance":"{}","title":"{}","transient_for":null}},"window_icon_padding":-1,)",
+                id % 100'000'000, window_class, window_class, name
+            );
+        }
+        else {
+            _out += R"("window":null,"window_type":null,"window_icon_padding":-1,)";
+        }
+        _out += R"("sticky":false,"floating":"auto_off","swallows":[],"fullscreen_mode":0,)";
+    }
+
+    void begin_nodes()          { _out += R"("nodes":[)"; }
+    void next_node()            { _out += ','; }
+    void begin_floating_nodes() { _out += R"(],"floating_nodes":[)"; }
+
+    /// Closes the container, writing its focus list
+    void close(std::vector<uint64_t> const & focus)
+    {
+        fmt::format_to(std::back_inserter(_out), R"(],"focus":[{}]}})", fmt::join(focus, ","));
+    }
+};
+} // namespace detail
+
+
+/**
+ * Loads a fixture recorded from a real i3 session
+ *
+ * \param directory The directory containing `tree.json`, `workspaces.json` and `outputs.json`
+ * */
+inline
+auto load_fixture(std::string const & directory, std::string name)
+    -> fixture
+{
+    auto tree = detail::read_file(directory + "/tree.json");
+    // Count the containers by counting their ids
+    auto containers = std::size_t{0};
+    for (auto pos = tree.find("\"id\":"); pos != std::string::npos; pos = tree.find("\"id\":", pos + 1)) {
+        ++containers;
+    }
+    return {
+        std::move(name),
+        containers,
+        std::move(tree),
+        detail::read_file(directory + "/workspaces.json"),
+        detail::read_file(directory + "/outputs.json"),
+    };
+}
+
+/**
+ * Generates a fixture with about `windows` containers, on two outputs with six workspaces each.
+ *
+ * The windows are spread across the workspaces in vertical splits of four, inside the horizontal
+ * layout of the workspace; one window in every fifty has a mark. Workspace 1 on the left output is
+ * focused, and workspace 11 is visible on the right one.
+ * */
+inline
+auto synthetic_fixture(std::size_t windows)
+    -> fixture
+{
+    constexpr auto ws_per_output = 6;
+    constexpr auto group_size = std::size_t{4};
+    constexpr auto width = 1920;
+    constexpr auto height = 1080;
+    auto const output_names = std::array{"DP-1", "HDMI-1"};
+
+    auto result = fixture{fmt::format("synthetic-{}", windows), 0, {}, {}, {}};
+    auto out = detail::tree_writer{result.tree};
+    auto window_count = std::size_t{0};
+    auto const windows_in = [windows, total = output_names.size() * ws_per_output](std::size_t ws) {
+        return windows / total + (ws < windows % total ? 1 : 0);
+    };
+
+    auto const root_id = out.next_id();
+    out.open(root_id, "root", "root", "splith", {0, 0, 2 * width, height}, false, "none");
+    out.begin_nodes();
+
+    // The scratchpad, always present
+    auto const i3_id = out.next_id();
+    auto const scratch_id = out.next_id();
+    out.open(i3_id, "output", "__i3", "output", {0, 0, 2 * width, height}, false, "__i3");
+    out.begin_nodes();
+    auto const content_i3 = out.next_id();
+    out.open(content_i3, "con", "content", "splith", {0, 0, 2 * width, height}, false, "__i3");
+    out.begin_nodes();
+    out.open(scratch_id, "workspace", "__i3_scratch", "splith", {0, 0, 2 * width, height}, false, "__i3");
+    out.begin_nodes();
+    out.begin_floating_nodes();
+    out.close({});
+    out.begin_floating_nodes();
+    out.close({scratch_id});
+    out.begin_floating_nodes();
+    out.close({content_i3});
+
+    auto workspaces = std::vector<std::string>{};
+    auto output_ids = std::vector<uint64_t>{};
+    for (auto o = std::size_t{0}; o < output_names.size(); ++o) {
+        auto const output_name = std::string_view{output_names[o]};
+        auto const x = static_cast<int>(o) * width;
+        auto const output_id = out.next_id();
+        output_ids.push_back(output_id);
+        out.next_node();
+        out.open(output_id, "output", output_name, "output", {x, 0, width, height}, false, output_name);
+        out.begin_nodes();
+
+        auto const topdock = out.next_id();
+        out.open(topdock, "dockarea", "topdock", "dockarea", {x, 0, width, 0}, false, output_name);
+        out.begin_nodes();
+        out.begin_floating_nodes();
+        out.close({});
+        out.next_node();
+
+        auto const content = out.next_id();
+        out.open(content, "con", "content", "splith", {x, 0, width, height - 20}, false, output_name);
+        out.begin_nodes();
+        auto ws_ids = std::vector<uint64_t>{};
+        for (auto w = 0; w < ws_per_output; ++w) {
+            auto const num = static_cast<int>(o) * 10 + w + 1;
+            auto const ws_index = o * ws_per_output + static_cast<std::size_t>(w);
+            auto const ws_id = out.next_id();
+            ws_ids.push_back(ws_id);
+            auto const visible = w == 0;
+            auto const focused_ws = visible and o == 0;
+            if (w != 0) {
+                out.next_node();
+            }
+            out.open(ws_id, "workspace", std::to_string(num), "splith", {x, 0, width, height - 20}, false, output_name);
+            out.begin_nodes();
+
+            auto const count = windows_in(ws_index);
+            auto const groups = (count + group_size - 1) / group_size;
+            auto group_ids = std::vector<uint64_t>{};
+            for (auto g = std::size_t{0}; g < groups; ++g) {
+                auto const in_group = std::min(group_size, count - g * group_size);
+                auto const group_width = width / static_cast<int>(groups);
+                auto const gx = x + static_cast<int>(g) * group_width;
+                auto const group_id = out.next_id();
+                group_ids.push_back(group_id);
+                if (g != 0) {
+                    out.next_node();
+                }
+                out.open(group_id, "con", "", "splitv", {gx, 0, group_width, height - 20}, false, output_name);
+                out.begin_nodes();
+                auto leaf_ids = std::vector<uint64_t>{};
+                for (auto l = std::size_t{0}; l < in_group; ++l) {
+                    auto const leaf_height = (height - 20) / static_cast<int>(in_group);
+                    auto const leaf_id = out.next_id();
+                    leaf_ids.push_back(leaf_id);
+                    auto const marks = window_count % 50 == 0
+                                     ? std::vector{fmt::format("m{}", window_count / 50)}
+                                     : std::vector<std::string>{};
+                    // the last window of the first group of the focused workspace has the focus
+                    auto const focused = focused_ws and g == 0 and l + 1 == in_group;
+                    if (l != 0) {
+                        out.next_node();
+                    }
+                    out.open(leaf_id, "con", fmt::format("terminal {}", window_count), "splith",
+                             {gx, static_cast<int>(l) * leaf_height, group_width, leaf_height},
+                             focused, output_name, marks, true);
+                    out.begin_nodes();
+                    out.begin_floating_nodes();
+                    out.close({});
+                    ++window_count;
+                }
+                out.begin_floating_nodes();
+                // the focus stack puts the last window first
+                std::ranges::reverse(leaf_ids);
+                out.close(leaf_ids);
+            }
+            out.begin_floating_nodes();
+            out.close(group_ids);
+
+            workspaces.push_back(fmt::format(
+                R"({{"id":{},"num":{},"name":"{}","visible":{},"focused":{},"urgent":false,)"
+                R"("rect":{{"x":{},"y":0,"width":{},"height":{}}},"output":"{}"}})",
+                ws_id, num, num, visible, focused_ws, x, width, height - 20, output_name
+            ));
+        }
+        out.begin_floating_nodes();
+        out.close(ws_ids);
+        out.next_node();
+
+        auto const bottomdock = out.next_id();
+        out.open(bottomdock, "dockarea", "bottomdock", "dockarea", {x, height - 20, width, 20}, false, output_name);
+        out.begin_nodes();
+        out.begin_floating_nodes();
+        out.close({});
+
+        out.begin_floating_nodes();
+        out.close({content, topdock, bottomdock});
+    }
+    out.begin_floating_nodes();
+    output_ids.insert(output_ids.begin() + 1, i3_id);
+    out.close(output_ids);
+
+    result.containers = window_count;
+    result.workspaces = fmt::format("[{}]", fmt::join(workspaces, ","));
+    result.outputs = fmt::format(
+        R"([{{"name":"eDP-1","active":false,"primary":false,"current_workspace":null,)"
+        R"("rect":{{"x":0,"y":0,"width":0,"height":0}}}},)"
+        R"({{"name":"DP-1","active":true,"primary":true,"current_workspace":"1",)"
+        R"("rect":{{"x":0,"y":0,"width":{0},"height":{1}}}}},)"
+        R"({{"name":"HDMI-1","active":true,"primary":false,"current_workspace":"11",)"
+        R"("rect":{{"x":{0},"y":0,"width":{0},"height":{1}}}}}])",
+        width, height
+    );
+    return result;
+}
+
+} // namespace brun::bench
+
+#endif /* BENCH_FIXTURES_HPP */
@@ -0,0 +1,284 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : latency
+ * @created     : Saturday Oct 17, 2026 00:21:40 CEST
+ * @description : runs each tool against a fake i3 and reports its wall time and its requests
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+#include <unistd.h>
+
+#include "fake_i3.hpp"
+#include "fixtures.hpp"
+#include "tool_runner.hpp"
+#include "utils.hpp"
+
+#ifndef BENCH_FIXTURES_DIR
+#define BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+#ifndef BENCH_TOOLS_DIR
+#define BENCH_TOOLS_DIR "build/bin"
+#endif
+
+namespace
+{
+using brun::bench::scenario;
+using brun::ipc::message_type;
+
+struct report
+{
+    std::string name;
+    std::size_t runs = 0;
+    std::size_t failures = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    std::size_t min_requests = 0;
+    std::size_t max_requests = 0;
+    std::size_t connections = 0;
+    std::map<message_type, std::size_t> by_type;  // of the first run
+    std::vector<std::string> commands;            // of the first run
+    bool same_commands = true;                    // every run sent the same commands
+};
+
+auto const message_names = std::map<std::string_view, message_type>{
+    {"run_command",    message_type::run_command},
+    {"get_workspaces", message_type::get_workspaces},
+    {"subscribe",      message_type::subscribe},
+    {"get_outputs",    message_type::get_outputs},
+    {"get_tree",       message_type::get_tree},
+    {"get_marks",      message_type::get_marks},
+    {"get_version",    message_type::get_version},
+};
+
+[[nodiscard]]
+auto message_name(message_type type)
+    -> std::string_view
+{
+    auto const found = std::ranges::find(message_names, type, [](auto const & entry) { return entry.second; });
+    return found != message_names.end() ? found->first : "other";
+}
+
+[[nodiscard]]
+auto measure(brun::bench::fake_i3 & server, std::string const & bin_dir, scenario const & sc,
+             std::size_t runs, brun::bench::environment const & env)
+    -> report
+{
+    using clock = std::chrono::steady_clock;
+    auto const binary = fmt::format("{}/{}", bin_dir, sc.tool);
+    auto argv = std::vector{binary};
+    argv.insert(argv.end(), sc.args.begin(), sc.args.end());
+    auto result = report{};
+    result.name = sc.name();
+    auto times = std::vector<double>{};
+    times.reserve(runs);
+
+    server.take_log();
+    for (auto i = std::size_t{0}; i < runs; ++i) {
+        auto const start = clock::now();
+        auto const status = brun::bench::run_process(binary, argv, env);
+        times.push_back(std::chrono::duration<double, std::micro>{clock::now() - start}.count());
+
+        auto log = server.take_log();
+        result.failures += status != 0 ? 1 : 0;
+        if (i == 0) {
+            result.min_requests = result.max_requests = log.requests;
+            result.connections = log.connections;
+            result.by_type = std::move(log.by_type);
+            result.commands = std::move(log.commands);
+        }
+        else {
+            result.min_requests = std::min(result.min_requests, log.requests);
+            result.max_requests = std::max(result.max_requests, log.requests);
+            result.same_commands = result.same_commands and log.commands == result.commands;
+        }
+    }
+
+    std::ranges::sort(times);
+    result.runs = runs;
+    result.p50_us = brun::bench::percentile(times, 0.50);
+    result.p99_us = brun::bench::percentile(times, 0.99);
+    result.max_us = times.empty() ? 0 : times.back();
+    return result;
+}
+
+void print(std::vector<report> const & reports)
+{
+    fmt::print("{:<36} {:>6} {:>6} {:>10} {:>10} {:>10} {:>9} {:>6}\n",
+        "scenario", "runs", "failed", "p50 us", "p99 us", "max us", "requests", "conns"
+    );
+    for (auto const & r : reports) {
+        auto const requests = r.min_requests == r.max_requests
+                            ? fmt::format("{}", r.min_requests)
+                            : fmt::format("{}-{}", r.min_requests, r.max_requests);
+        fmt::print("{:<36} {:>6} {:>6} {:>10.0f} {:>10.0f} {:>10.0f} {:>9} {:>6}\n",
+            r.name, r.runs, r.failures, r.p50_us, r.p99_us, r.max_us, requests, r.connections
+        );
+    }
+    for (auto const & r : reports) {
+        fmt::print("\n{}:", r.name);
+        for (auto const & [type, count] : r.by_type) {
+            fmt::print(" {}={}", message_name(type), count);
+        }
+        fmt::print("{}\n", r.same_commands ? "" : " (the commands changed between runs)");
+        for (auto const & command : r.commands) {
+            fmt::print("    {}\n", command);
+        }
+    }
+}
+
+[[nodiscard]]
+auto escape(std::string_view text)
+    -> std::string
+{
+    auto result = std::string{};
+    for (auto const c : text) {
+        if (c == '"' or c == '\\') {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+void write_json(std::FILE * out, std::vector<report> const & reports)
+{
+    fmt::print(out, "[\n");
+    for (auto i = std::size_t{0}; i < reports.size(); ++i) {
+        auto const & r = reports[i];
+        auto const commands = r.commands | std::views::transform([](auto const & command) {
+            return fmt::format("\"{}\"", escape(command));
+        });
+        fmt::print(out,
+            R"(  {{"scenario": "{}", "runs": {}, "failures": {}, "p50_us": {:.1f}, "p99_us": {:.1f}, )"
+            R"("max_us": {:.1f}, "requests": {}, "connections": {}, "commands": [{}]}}{})" "\n",
+            r.name, r.runs, r.failures, r.p50_us, r.p99_us, r.max_us, r.max_requests, r.connections,
+            fmt::join(commands, ", "), i + 1 < reports.size() ? "," : ""
+        );
+    }
+    fmt::print(out, "]\n");
+}
+
+void usage(char const * name)
+{
+    fmt::print(stderr,
+        "Usage: {} [--bin <dir>] [--fixtures <dir>] [--fixture <name>] [--runs <n>] [--filter <text>]\n"
+        "          [--delay <request>=<us>]... [--socket <path>] [--json <file>]\n"
+        "Requests: run_command, get_workspaces, subscribe, get_outputs, get_tree, get_marks, get_version\n",
+        name
+    );
+}
+} // namespace
+
+int main(int argc, char const * argv[])
+try {
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    auto bin_dir = std::string{BENCH_TOOLS_DIR};
+    auto fixtures_dir = std::string{BENCH_FIXTURES_DIR};
+    auto fixture_name = std::string{"laptop"};
+    auto runs = std::size_t{1000};
+    auto filter = std::string{};
+    auto socket = fmt::format("/tmp/fake-i3-{}.sock", ::getpid());
+    auto json_path = std::string{};
+    auto delays = std::map<message_type, std::chrono::microseconds>{};
+
+    for (auto i = std::size_t{1}; i < args.size(); ++i) {
+        auto const arg = std::string_view{args[i]};
+        if (i + 1 == args.size()) {
+            usage(args[0]);
+            return 1;
+        }
+        auto const value = std::string{args[++i]};
+        if (arg == "--bin") {
+            bin_dir = value;
+        }
+        else if (arg == "--fixtures") {
+            fixtures_dir = value;
+        }
+        else if (arg == "--fixture") {
+            fixture_name = value;
+        }
+        else if (arg == "--runs") {
+            runs = static_cast<std::size_t>(std::max(brun::stoi(value).value_or(1), 1));
+        }
+        else if (arg == "--filter") {
+            filter = value;
+        }
+        else if (arg == "--socket") {
+            socket = value;
+        }
+        else if (arg == "--json") {
+            json_path = value;
+        }
+        else if (arg == "--delay") {
+            auto const equal = value.find('=');
+            auto const type = message_names.find(std::string_view{value}.substr(0, equal));
+            auto const us = equal != std::string::npos ? brun::stoi(value.substr(equal + 1)) : tl::nullopt;
+            if (type == message_names.end() or not us.has_value()) {
+                usage(args[0]);
+                return 1;
+            }
+            delays[type->second] = std::chrono::microseconds{*us};
+        }
+        else {
+            usage(args[0]);
+            return 1;
+        }
+    }
+
+    // A tool closing its socket early must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto server = brun::bench::fake_i3{
+        socket,
+        brun::bench::load_fixture(fmt::format("{}/{}", fixtures_dir, fixture_name), fixture_name),
+        delays
+    };
+
+    // The tools talk to the fake i3 directly, never to a running daemon
+    auto const env = brun::bench::environment{{
+        {"I3SOCK", socket},
+        {"I3_TOOLS_NO_DAEMON", "1"},
+    }};
+
+    auto reports = std::vector<report>{};
+    for (auto const & sc : brun::bench::default_scenarios) {
+        if (not filter.empty() and sc.name().find(filter) == std::string::npos) {
+            continue;
+        }
+        if (not brun::bench::is_executable(fmt::format("{}/{}", bin_dir, sc.tool))) {
+            fmt::print(stderr, "Skipping '{}': {}/{} is not an executable\n", sc.name(), bin_dir, sc.tool);
+            continue;
+        }
+        reports.push_back(measure(server, bin_dir, sc, runs, env));
+    }
+
+    print(reports);
+    if (not json_path.empty()) {
+        auto * out = std::fopen(json_path.c_str(), "w");
+        if (out == nullptr) {
+            fmt::print(stderr, "Cannot write {}\n", json_path);
+            return 1;
+        }
+        write_json(out, reports);
+        std::fclose(out);
+    }
+}
+catch (std::exception const & exc) {
+    fmt::print(stderr, "{}\n", exc.what());
+    return 1;
+}
@@ -0,0 +1,256 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : launch_storm
+ * @created     : Saturday Oct 17, 2026 12:04:37 CEST
+ * @description : launches many programs with exec at once, and checks that every window is placed once
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include "fake_i3.hpp"
+#include "fixtures.hpp"
+#include "tool_runner.hpp"
+#include "utils.hpp"
+
+#ifndef BENCH_FIXTURES_DIR
+#define BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+#ifndef BENCH_TOOLS_DIR
+#define BENCH_TOOLS_DIR "build/bin"
+#endif
+
+namespace
+{
+struct options
+{
+    std::string bin_dir = BENCH_TOOLS_DIR;
+    std::string fixtures_dir = BENCH_FIXTURES_DIR;
+    std::string fixture = "laptop";
+    std::size_t clients = 50;
+    std::chrono::milliseconds max_delay{200};
+};
+
+struct outcome
+{
+    std::size_t failures = 0;           // clients which did not exit with 0
+    double client_p50_ms = 0;           // from the start of the storm to the exit of the client
+    double client_p99_ms = 0;
+    double placed_ms = 0;               // from the start of the storm to the last placement
+    std::size_t placed_once = 0;
+    std::size_t placed_more = 0;        // windows placed by more than one launch
+    std::size_t missing = 0;            // windows never placed
+    std::size_t messages = 0;           // RUN_COMMAND messages placing windows
+};
+
+/// The id of the window a placement command is about, from `[con_id=<id>] move to workspace ...`
+[[nodiscard]]
+auto placed_window(std::string_view command)
+    -> tl::optional<std::string_view>
+{
+    constexpr auto prefix = std::string_view{"[con_id="};
+    if (not command.starts_with(prefix) or command.find("move to workspace") == std::string_view::npos) {
+        return tl::nullopt;
+    }
+    auto const end = command.find(']');
+    return command.substr(prefix.size(), end - prefix.size());
+}
+
+/**
+ * Counts how many times each window was placed, from the commands received by the fake i3
+ * */
+void count_placements(brun::bench::fake_i3_log const & log, std::size_t clients, outcome & result)
+{
+    auto placements = std::map<std::string_view, std::size_t>{};
+    for (auto const & message : log.commands) {
+        auto placing = false;
+        for (auto pos = std::size_t{0}; pos < message.size(); ) {
+            auto const end = std::min(message.find(';', pos), message.size());
+            auto command = std::string_view{message}.substr(pos, end - pos);
+            command.remove_prefix(std::min(command.find_first_not_of(' '), command.size()));
+            if (auto const window = placed_window(command); window.has_value()) {
+                ++placements[*window];
+                placing = true;
+            }
+            pos = end + 1;
+        }
+        result.messages += placing ? 1 : 0;
+    }
+    for (auto const & [window, count] : placements) {
+        (count == 1 ? result.placed_once : result.placed_more) += 1;
+    }
+    result.missing = clients - std::min(clients, placements.size());
+}
+
+/**
+ * Starts `clients` exec at once, each running its own program, and waits until every window is
+ * placed or the launches expire
+ * */
+[[nodiscard]]
+auto storm(brun::bench::fake_i3 & server, std::string const & exec_path, std::size_t clients,
+           brun::bench::environment const & env)
+    -> outcome
+{
+    auto result = outcome{};
+    (void)server.take_log();
+    auto pids = std::vector<pid_t>{};
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = std::size_t{0}; i < clients; ++i) {
+        pids.push_back(brun::bench::spawn_process(exec_path, {exec_path, fmt::format("program-{}", i)}, env));
+    }
+    auto times = std::vector<double>{};
+    for (auto const pid : pids) {
+        result.failures += pid < 0 or brun::bench::wait_process(pid) != 0 ? 1 : 0;
+        times.push_back(std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count());
+    }
+    std::ranges::sort(times);
+    result.client_p50_ms = brun::bench::percentile(times, 0.50);
+    result.client_p99_ms = brun::bench::percentile(times, 0.99);
+
+    // The daemon places the windows after its clients exited; the launches expire after 7 seconds
+    auto const give_up = start + std::chrono::seconds{8};
+    auto seen = std::size_t{0};
+    while (std::chrono::steady_clock::now() < give_up) {
+        auto probe = outcome{};
+        auto const log = server.log();
+        count_placements(log, clients, probe);
+        if (probe.placed_once + probe.placed_more != seen) {
+            seen = probe.placed_once + probe.placed_more;
+            result.placed_ms = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+        }
+        if (probe.missing == 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    }
+    count_placements(server.log(), clients, result);
+    return result;
+}
+
+/**
+ * Starts i3_toolsd on its own socket and waits for it to accept clients
+ * */
+[[nodiscard]]
+auto start_daemon(std::string const & path, std::string const & socket, brun::bench::environment const & env)
+    -> pid_t
+{
+    auto const pid = brun::bench::spawn_process(path, {path}, env);
+    for (auto i = 0; pid > 0 and i < 200 and not std::filesystem::exists(socket); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return pid;
+}
+
+void print(std::string_view mode, outcome const & o)
+{
+    fmt::print("{:<12} {:>10} {:>16} {:>14} {:>8} {:>8} {:>8} {:>9}\n",
+        mode,
+        o.failures,
+        fmt::format("{:.1f}/{:.1f}", o.client_p50_ms, o.client_p99_ms),
+        fmt::format("{:.1f}", o.placed_ms),
+        o.placed_once, o.placed_more, o.missing, o.messages
+    );
+}
+
+void usage(char const * name)
+{
+    fmt::print(stderr,
+        "Usage: {} [--bin <dir>] [--fixtures <dir>] [--fixture <name>] [--clients <n>] [--max-delay <ms>]\n",
+        name
+    );
+}
+} // namespace
+
+int main(int argc, char const * argv[])
+try {
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    auto opts = options{};
+    for (auto i = std::size_t{1}; i < args.size(); ++i) {
+        auto const arg = std::string_view{args[i]};
+        if (i + 1 == args.size()) {
+            usage(args[0]);
+            return 1;
+        }
+        auto const value = std::string{args[++i]};
+        if (arg == "--bin") {
+            opts.bin_dir = value;
+        }
+        else if (arg == "--fixtures") {
+            opts.fixtures_dir = value;
+        }
+        else if (arg == "--fixture") {
+            opts.fixture = value;
+        }
+        else if (arg == "--clients") {
+            opts.clients = static_cast<std::size_t>(std::max(brun::stoi(value).value_or(1), 1));
+        }
+        else if (arg == "--max-delay") {
+            opts.max_delay = std::chrono::milliseconds{std::max(brun::stoi(value).value_or(0), 0)};
+        }
+        else {
+            usage(args[0]);
+            return 1;
+        }
+    }
+
+    auto const exec_path = fmt::format("{}/exec", opts.bin_dir);
+    auto const daemon_path = fmt::format("{}/i3_toolsd", opts.bin_dir);
+    if (not brun::bench::is_executable(exec_path)) {
+        fmt::print(stderr, "{} is not an executable\n", exec_path);
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    auto const socket = fmt::format("/tmp/fake-i3-{}.sock", ::getpid());
+    auto const daemon_socket = fmt::format("/tmp/i3_toolsd-storm-{}.sock", ::getpid());
+    auto server = brun::bench::fake_i3{
+        socket,
+        brun::bench::load_fixture(fmt::format("{}/{}", opts.fixtures_dir, opts.fixture), opts.fixture)
+    };
+    // The windows appear in a different order than the launches, like in a session restore
+    server.delay_windows(opts.max_delay);
+
+    fmt::print("{} clients, windows delayed up to {} ms\n", opts.clients, opts.max_delay.count());
+    fmt::print("{:<12} {:>10} {:>16} {:>14} {:>8} {:>8} {:>8} {:>9}\n",
+               "mode", "failures", "client p50/p99", "all placed ms", "once", "more", "missing", "messages");
+
+    auto const standalone = brun::bench::environment{{
+        {"I3SOCK", socket},
+        {"I3_TOOLS_NO_DAEMON", "1"},
+    }};
+    print("standalone", storm(server, exec_path, opts.clients, standalone));
+
+    if (brun::bench::is_executable(daemon_path)) {
+        auto const with_daemon = brun::bench::environment{{
+            {"I3SOCK", socket},
+            {"I3_TOOLSD_SOCKET", daemon_socket},
+        }};
+        auto const daemon = start_daemon(daemon_path, daemon_socket, with_daemon);
+        print("daemon", storm(server, exec_path, opts.clients, with_daemon));
+        if (daemon > 0) {
+            ::kill(daemon, SIGTERM);
+            (void)brun::bench::wait_process(daemon);
+        }
+        std::filesystem::remove(daemon_socket);
+    }
+    else {
+        fmt::print(stderr, "{} is not an executable, skipping the daemon\n", daemon_path);
+    }
+}
+catch (std::exception const & exc) {
+    fmt::print(stderr, "{}\n", exc.what());
+    return 1;
+}
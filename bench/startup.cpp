@@ -0,0 +1,182 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : startup
+ * @created     : Saturday Oct 17, 2026 01:44:52 CEST
+ * @description : compares the exec-to-exit time of the separate tools with the one of i3_tools
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+
+#include <unistd.h>
+
+#include "fake_i3.hpp"
+#include "fixtures.hpp"
+#include "tool_runner.hpp"
+#include "utils.hpp"
+
+#ifndef BENCH_FIXTURES_DIR
+#define BENCH_FIXTURES_DIR "bench/fixtures"
+#endif
+#ifndef BENCH_TOOLS_DIR
+#define BENCH_TOOLS_DIR "build/bin"
+#endif
+
+namespace
+{
+struct timing
+{
+    double p50_us = 0;
+    double p99_us = 0;
+    std::size_t failures = 0;
+};
+
+/**
+ * Runs the same command `runs` times
+ * */
+[[nodiscard]]
+auto time_runs(std::string const & path, std::vector<std::string> const & argv,
+               brun::bench::environment const & env, std::size_t runs)
+    -> timing
+{
+    using clock = std::chrono::steady_clock;
+    auto result = timing{};
+    auto times = std::vector<double>{};
+    times.reserve(runs);
+    for (auto i = std::size_t{0}; i < runs; ++i) {
+        auto const start = clock::now();
+        result.failures += brun::bench::run_process(path, argv, env) != 0 ? 1 : 0;
+        times.push_back(std::chrono::duration<double, std::micro>{clock::now() - start}.count());
+    }
+    std::ranges::sort(times);
+    result.p50_us = brun::bench::percentile(times, 0.50);
+    result.p99_us = brun::bench::percentile(times, 0.99);
+    return result;
+}
+
+void usage(char const * name)
+{
+    fmt::print(stderr,
+        "Usage: {} [--bin <dir>] [--fixtures <dir>] [--fixture <name>] [--runs <n>] [--filter <text>]\n",
+        name
+    );
+}
+} // namespace
+
+int main(int argc, char const * argv[])
+try {
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    auto bin_dir = std::string{BENCH_TOOLS_DIR};
+    auto fixtures_dir = std::string{BENCH_FIXTURES_DIR};
+    auto fixture_name = std::string{"laptop"};
+    auto runs = std::size_t{500};
+    auto filter = std::string{};
+
+    for (auto i = std::size_t{1}; i < args.size(); ++i) {
+        auto const arg = std::string_view{args[i]};
+        if (i + 1 == args.size()) {
+            usage(args[0]);
+            return 1;
+        }
+        auto const value = std::string{args[++i]};
+        if (arg == "--bin") {
+            bin_dir = value;
+        }
+        else if (arg == "--fixtures") {
+            fixtures_dir = value;
+        }
+        else if (arg == "--fixture") {
+            fixture_name = value;
+        }
+        else if (arg == "--runs") {
+            runs = static_cast<std::size_t>(std::max(brun::stoi(value).value_or(1), 1));
+        }
+        else if (arg == "--filter") {
+            filter = value;
+        }
+        else {
+            usage(args[0]);
+            return 1;
+        }
+    }
+
+    auto const multi_call = fmt::format("{}/i3_tools", bin_dir);
+    if (not brun::bench::is_executable(multi_call)) {
+        fmt::print(stderr, "{} is not an executable\n", multi_call);
+        return 1;
+    }
+
+    // The symlinks are what `update` installs, and exercise the dispatch on argv[0]
+    auto const links = std::filesystem::temp_directory_path() / fmt::format("i3_tools-startup-{}", ::getpid());
+    std::filesystem::create_directories(links);
+    for (auto const & sc : brun::bench::default_scenarios) {
+        auto const link = links / sc.tool;
+        if (not std::filesystem::exists(std::filesystem::symlink_status(link))) {
+            std::filesystem::create_symlink(std::filesystem::absolute(multi_call), link);
+        }
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    auto const socket = fmt::format("/tmp/fake-i3-{}.sock", ::getpid());
+    auto const server = brun::bench::fake_i3{
+        socket,
+        brun::bench::load_fixture(fmt::format("{}/{}", fixtures_dir, fixture_name), fixture_name)
+    };
+    auto const env = brun::bench::environment{{
+        {"I3SOCK", socket},
+        {"I3_TOOLS_NO_DAEMON", "1"},
+    }};
+
+    // The cost of creating a process, which no binary can avoid
+    auto const floor = time_runs("/bin/true", {"true"}, env, runs);
+    fmt::print("{:<36} {:>22} {:>22} {:>22} {:>8}\n", "p50/p99 us", "separate", "i3_tools <tool>", "symlink", "ratio");
+    fmt::print("{:<36} {:>22}\n", "/bin/true", fmt::format("{:.0f}/{:.0f}", floor.p50_us, floor.p99_us));
+
+    for (auto const & sc : brun::bench::default_scenarios) {
+        if (not filter.empty() and sc.name().find(filter) == std::string::npos) {
+            continue;
+        }
+        auto const separate_path = fmt::format("{}/{}", bin_dir, sc.tool);
+        auto const link = (links / sc.tool).string();
+
+        auto separate_argv = std::vector{separate_path};
+        auto subcommand_argv = std::vector{multi_call, sc.tool};
+        auto link_argv = std::vector{link};
+        for (auto const & arg : sc.args) {
+            separate_argv.push_back(arg);
+            subcommand_argv.push_back(arg);
+            link_argv.push_back(arg);
+        }
+
+        auto const separate = brun::bench::is_executable(separate_path)
+                            ? time_runs(separate_path, separate_argv, env, runs)
+                            : timing{};
+        auto const subcommand = time_runs(multi_call, subcommand_argv, env, runs);
+        auto const symlink = time_runs(link, link_argv, env, runs);
+
+        auto const format = [](timing const & t) {
+            return t.failures == 0
+                 ? fmt::format("{:.0f}/{:.0f}", t.p50_us, t.p99_us)
+                 : fmt::format("{:.0f}/{:.0f} ({} failed)", t.p50_us, t.p99_us, t.failures);
+        };
+        fmt::print("{:<36} {:>22} {:>22} {:>22} {:>8}\n",
+            sc.name(),
+            separate.p50_us > 0 ? format(separate) : "-",
+            format(subcommand),
+            format(symlink),
+            separate.p50_us > 0 ? fmt::format("{:.2f}", symlink.p50_us / separate.p50_us) : "-"
+        );
+    }
+    std::filesystem::remove_all(links);
+}
+catch (std::exception const & exc) {
+    fmt::print(stderr, "{}\n", exc.what());
+    return 1;
+}
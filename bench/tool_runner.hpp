@@ -0,0 +1,171 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tool_runner
+ * @created     : Saturday Oct 17, 2026 01:27:15 CEST
+ * @description : Runs the tools as separate processes, for the benchmarks of whole invocations
+ * */
+
+#ifndef BENCH_TOOL_RUNNER_HPP
+#define BENCH_TOOL_RUNNER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char ** environ;
+
+namespace brun::bench
+{
+
+/**
+ * A tool and the arguments it is run with
+ * */
+struct scenario
+{
+    std::string tool;
+    std::vector<std::string> args;
+
+    [[nodiscard]] auto name() const
+    { return args.empty() ? tool : fmt::format("{} {}", tool, fmt::join(args, " ")); }
+};
+
+/// The scenarios run by default; the marks exist in the recorded fixtures
+inline auto const default_scenarios = std::vector<scenario>{
+    {"focus_window",    {"left"}},
+    {"focus_window",    {"right"}},
+    {"focus_workspace", {"3"}},
+    {"focus_workspace", {"music"}},
+    {"focus_workspace", {"--container", "editor"}},
+    {"mv_container",    {"3"}},
+    {"mv_to_output",    {"next"}},
+    {"exec",            {"true"}},
+    {"fix_workspaces",  {}},
+};
+
+/**
+ * The environment of the current process with some variables replaced, in the form expected by
+ * `posix_spawn`
+ * */
+class environment
+{
+private:
+    std::vector<std::string> _storage;
+    std::vector<char *> _pointers;
+
+public:
+    explicit environment(std::map<std::string, std::string> const & overrides)
+    {
+        for (auto const & [name, value] : overrides) {
+            _storage.push_back(fmt::format("{}={}", name, value));
+        }
+        for (auto ** var = environ; *var != nullptr; ++var) {
+            auto const entry = std::string_view{*var};
+            auto const name = entry.substr(0, entry.find('='));
+            if (not overrides.contains(std::string{name})) {
+                _storage.emplace_back(entry);
+            }
+        }
+        for (auto & entry : _storage) {
+            _pointers.push_back(entry.data());
+        }
+        _pointers.push_back(nullptr);
+    }
+
+    environment(environment const &) = delete;
+    environment & operator=(environment const &) = delete;
+
+    [[nodiscard]] auto data() const noexcept { return _pointers.data(); }
+};
+
+/**
+ * Starts a program, with its output discarded
+ *
+ * \param path The path of the executable
+ * \param argv The arguments, starting from `argv[0]`
+ * \param env The environment of the program
+ * \returns The pid of the program, or -1 if it could not be started
+ * */
+[[nodiscard]] inline
+auto spawn_process(std::string const & path, std::vector<std::string> const & argv, environment const & env)
+    -> pid_t
+{
+    auto pointers = std::vector<char *>{};
+    for (auto const & arg : argv) {
+        pointers.push_back(const_cast<char *>(arg.c_str()));
+    }
+    pointers.push_back(nullptr);
+
+    auto actions = posix_spawn_file_actions_t{};
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    ::posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    auto pid = pid_t{};
+    auto const error = ::posix_spawn(&pid, path.c_str(), &actions, nullptr, pointers.data(), env.data());
+    ::posix_spawn_file_actions_destroy(&actions);
+    return error == 0 ? pid : -1;
+}
+
+/**
+ * Waits for a program started with `spawn_process`
+ *
+ * \returns The exit status of the program, or -1 if it was killed
+ * */
+[[nodiscard]] inline
+int wait_process(pid_t pid)
+{
+    auto status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/**
+ * Runs a program and waits for it, with its output discarded
+ *
+ * \returns The exit status of the program, or -1 if it could not be started or was killed
+ * */
+[[nodiscard]] inline
+int run_process(std::string const & path, std::vector<std::string> const & argv, environment const & env)
+{
+    auto const pid = spawn_process(path, argv, env);
+    return pid < 0 ? -1 : wait_process(pid);
+}
+
+/// Check if `path` can be run
+[[nodiscard]] inline
+bool is_executable(std::string const & path)
+{
+    return ::access(path.c_str(), X_OK) == 0;
+}
+
+/**
+ * \param sorted The samples, in increasing order
+ * \param p The percentile, between 0 and 1
+ * */
+[[nodiscard]] inline
+auto percentile(std::vector<double> const & sorted, double p)
+    -> double
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    auto const index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace brun::bench
+
+#endif /* BENCH_TOOL_RUNNER_HPP */
@@ -93,6 +93,17 @@ function(enable_lto target_name)
     endif()
 endfunction()
 
+# startup profile
+option(ENABLE_STARTUP_PROFILE "Link the tools statically and drop the unused code, to start them faster" OFF)
+function(enable_startup_profile target_name)
+    if (ENABLE_STARTUP_PROFILE)
+        # No dynamic loader and no relocations at startup: all the dependencies must be available
+        #  as static libraries (the default for conan packages)
+        target_compile_options(${target_name} PRIVATE -ffunction-sections -fdata-sections)
+        target_link_options(${target_name} PRIVATE -static -Wl,--gc-sections -Wl,-O1)
+    endif()
+endfunction()
+
 # force colors in compiler output
 option (FORCE_COLORED_OUTPUT "Always produce ANSI-colored output (GNU/Clang only)." FALSE)
 mark_as_advanced(FORCE_COLORED_OUTPUT)
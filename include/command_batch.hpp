@@ -0,0 +1,242 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : command_batch
+ * @created     : Friday Oct 16, 2026 19:05:36 CEST
+ * @description : Accumulates i3 commands and sends them in a single message
+ * */
+
+#ifndef COMMAND_BATCH_HPP
+#define COMMAND_BATCH_HPP
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+#include <tl/optional.hpp>
+
+#include "ipc.hpp"
+#include "detail/json.hpp"
+
+namespace brun
+{
+
+struct command_result
+{
+    bool success = false;
+    std::string error;
+};
+
+/**
+ * The outcome of a batch, with one result for each command that was added to it
+ * */
+class batch_result
+{
+private:
+    std::vector<command_result> _results;
+
+public:
+    explicit batch_result(std::vector<command_result> results) : _results{std::move(results)} {}
+
+    /// `true` if all the commands succeeded
+    [[nodiscard]] explicit operator bool() const noexcept { return not first_failure().has_value(); }
+
+    [[nodiscard]] auto results() const noexcept -> std::span<command_result const> { return _results; }
+
+    /**
+     * Returns the index of the first command that failed, if any
+     * */
+    [[nodiscard]]
+    auto first_failure() const noexcept
+        -> tl::optional<std::size_t>
+    {
+        for (auto i = std::size_t{0}; i < _results.size(); ++i) {
+            if (not _results[i].success) {
+                return i;
+            }
+        }
+        return tl::nullopt;
+    }
+};
+
+namespace detail
+{
+/**
+ * Counts the results i3 sends back for a command string: one for each command separated by ';'
+ * or ',' outside of quotes and criteria
+ * */
+[[nodiscard]] inline
+auto count_commands(std::string_view commands)
+    -> std::size_t
+{
+    auto count = std::size_t{1};
+    auto quoted = false;
+    auto criteria = false;
+    for (auto i = std::size_t{0}; i < commands.size(); ++i) {
+        auto const c = commands[i];
+        if (quoted) {
+            if (c == '\\') {
+                ++i;
+            }
+            else if (c == '"') {
+                quoted = false;
+            }
+            continue;
+        }
+        switch (c) {
+        case '"': quoted = true; break;
+        case '[': criteria = true; break;
+        case ']': criteria = false; break;
+        case ';': case ',': count += criteria ? 0 : 1; break;
+        default: break;
+        }
+    }
+    return count;
+}
+
+/**
+ * Decodes the reply to RUN_COMMAND, an array with an object for each command
+ * */
+[[nodiscard]] inline
+auto parse_command_reply(std::string_view reply)
+    -> std::vector<command_result>
+{
+    auto results = std::vector<command_result>{};
+    auto json = json::reader{reply};
+    json.begin_array();
+    while (json.next_element()) {
+        auto & result = results.emplace_back();
+        json.begin_object();
+        while (auto const key = json.next_key()) {
+            if (*key == "success") {
+                result.success = json.read_bool();
+            }
+            else if (*key == "error") {
+                result.error = json.read_string();
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+    return results;
+}
+} // namespace detail
+
+
+/**
+ * Quotes a string to be used as an argument of a command (e.g. a workspace name)
+ * */
+[[nodiscard]] inline
+auto quote(std::string_view text)
+    -> std::string
+{
+    auto result = std::string{"\""};
+    for (auto const c : text) {
+        if (c == '"' or c == '\\') {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+/**
+ * Builds the quoted value of a criterion matching exactly `text`, e.g. `[workspace=...]`, since
+ * i3 interprets criteria as regular expressions
+ * */
+[[nodiscard]] inline
+auto exact_match(std::string_view text)
+    -> std::string
+{
+    auto pattern = std::string{"^"};
+    for (auto const c : text) {
+        if (std::string_view{".^$|()[]{}*+?\\"}.find(c) != std::string_view::npos) {
+            pattern.push_back('\\');
+        }
+        pattern.push_back(c);
+    }
+    pattern.push_back('$');
+    return quote(pattern);
+}
+
+/**
+ * A list of commands to be sent to i3 in a single RUN_COMMAND message, so that they cost one
+ * round trip and i3 redraws only once, after the last one.
+ *
+ * Each command added can itself contain more commands separated by ';' or ','; the results sent
+ * back by i3 are mapped to the entries they belong to.
+ * */
+class command_batch
+{
+private:
+    std::vector<std::string> _commands;
+
+public:
+    template <typename ...Args>
+    auto add(fmt::format_string<Args...> format, Args && ...args)
+        -> command_batch &
+    {
+        _commands.push_back(fmt::format(format, std::forward<Args>(args)...));
+        return *this;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return _commands.empty(); }
+    [[nodiscard]] auto size() const noexcept { return _commands.size(); }
+    [[nodiscard]] auto commands() const noexcept -> std::span<std::string const> { return _commands; }
+
+    void clear() noexcept { _commands.clear(); }
+
+    /// All the commands, joined as i3 expects them
+    [[nodiscard]]
+    auto str() const
+        -> std::string
+    {
+        auto result = std::string{};
+        for (auto const & command : _commands) {
+            if (not result.empty()) {
+                result += "; ";
+            }
+            result += command;
+        }
+        return result;
+    }
+
+    /**
+     * Sends all the commands in a single message
+     *
+     * \param i3 The connection to use
+     * \returns The result of each command; the commands not reached because of a parse error are
+     *          reported as failed
+     * */
+    auto submit(ipc::connection & i3) const
+        -> batch_result
+    {
+        if (empty()) {
+            return batch_result{{}};
+        }
+        auto const replies = detail::parse_command_reply(i3.request_view(ipc::message_type::run_command, str()));
+
+        auto results = std::vector<command_result>{};
+        results.reserve(_commands.size());
+        auto reply = replies.begin();
+        for (auto const & command : _commands) {
+            auto & result = results.emplace_back(command_result{true, {}});
+            for (auto n = detail::count_commands(command); n > 0; --n, ++reply) {
+                if (reply == replies.end()) {
+                    result = {false, "not executed"};
+                    break;
+                }
+                if (not reply->success and result.success) {
+                    result = *reply;
+                }
+            }
+        }
+        return batch_result{std::move(results)};
+    }
+};
+
+} // namespace brun
+
+#endif /* COMMAND_BATCH_HPP */
@@ -0,0 +1,507 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : context
+ * @created     : Friday Oct 16, 2026 16:48:30 CEST
+ * @description : State of i3 fetched lazily and shared by the functions working on it
+ * */
+
+#ifndef CONTEXT_HPP
+#define CONTEXT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "command_batch.hpp"
+#include "ipc.hpp"
+#include "detail/i3_json.hpp"
+#include "lazy_tree.hpp"
+#include "marks.hpp"
+#include "output_topology.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
+#include "workspace_history.hpp"
+#include "workspace_index.hpp"
+
+namespace brun
+{
+
+/// \name Requests decoded with the readers of `json`
+/// \{
+[[nodiscard]] inline
+auto get_tree(ipc::connection & i3)
+    -> i3_containers::node
+{
+    auto json = json::reader{i3.request_view(ipc::message_type::get_tree)};
+    return json::read_node(json);
+}
+
+[[nodiscard]] inline
+auto get_workspaces(ipc::connection & i3)
+    -> std::vector<i3_containers::workspace>
+{
+    auto json = json::reader{i3.request_view(ipc::message_type::get_workspaces)};
+    return json::read_workspaces(json);
+}
+
+[[nodiscard]] inline
+auto get_outputs(ipc::connection & i3)
+    -> std::vector<i3_containers::output>
+{
+    auto json = json::reader{i3.request_view(ipc::message_type::get_outputs)};
+    return json::read_outputs(json);
+}
+/// \}
+
+/**
+ * The state of i3 as seen by a single operation.
+ *
+ * Each reply (tree, workspaces, outputs, marks) is fetched the first time it is needed and then
+ * reused, so that the functions working on the same state do not ask i3 again for it. Executing
+ * a command through the context drops everything, since the command could have changed it.
+ *
+ * A context can also be detached from i3: its replies are provided with the `set_*` functions
+ * and the commands are only recorded (see `recorded_commands`), which is useful to evaluate an
+ * operation on a known state.
+ *
+ * Note that the references returned by the accessors are invalidated by `execute_commands`,
+ * `execute` and `invalidate`.
+ * */
+class context
+{
+public:
+    /// The replies that can be fetched in advance with `prefetch`; the index of the marks is built
+    ///  from the tree, which is fetched only if the index is not available otherwise, and the focus
+    ///  chain is not fetched if the whole tree is available
+    enum class reply : std::uint8_t { tree, flat_tree, workspaces, outputs, marks, marks_index, focus_chain };
+
+private:
+    ipc::connection * _i3 = nullptr;   // owned by the caller, so that it is opened once
+    mutable i3_containers::node const * _seed = nullptr;
+    mutable brun::mark_index const * _seed_marks = nullptr;
+    mutable brun::output_topology const * _seed_topology = nullptr;
+
+    mutable tl::optional<i3_containers::node> _tree;
+    mutable tl::optional<brun::snapshot> _flat_tree;
+    mutable tl::optional<brun::mark_index> _mark_index;
+    mutable tl::optional<std::vector<i3_containers::workspace>> _workspaces;
+    mutable tl::optional<brun::workspace_index> _workspace_index;
+    mutable tl::optional<std::vector<i3_containers::output>> _outputs;
+    mutable tl::optional<brun::output_topology> _output_topology;
+    mutable tl::optional<std::vector<std::string>> _marks;
+    mutable bool _executed_commands = false;
+    mutable tl::optional<std::vector<chain_node>> _focus_chain;
+    brun::workspace_history const * _history = nullptr;   // kept by a watcher, if any
+    bool _watched = false;                                // the events are followed by the owner
+    std::function<void()> _before_commands;               // run before sending the first command
+    mutable std::vector<std::string> _recorded;           // commands of a detached context
+
+    template <typename T, typename Fetch>
+    static auto memoized(tl::optional<T> & cache, Fetch && fetch)
+        -> T const &
+    {
+        if (not cache.has_value()) {
+            cache.emplace(fetch());
+        }
+        return *cache;
+    }
+
+    auto connection() const
+        -> ipc::connection &
+    {
+        if (_i3 == nullptr) {
+            throw std::logic_error{"detached context: the reply was not provided"};
+        }
+        return *_i3;
+    }
+
+    [[nodiscard]]
+    bool is_available(reply r) const noexcept
+    {
+        switch (r) {
+        case reply::tree:        return has_tree();
+        case reply::flat_tree:   return _flat_tree.has_value() or has_tree();
+        case reply::workspaces:  return _workspaces.has_value();
+        case reply::outputs:     return _outputs.has_value() or _seed_topology != nullptr;
+        case reply::marks:       return _marks.has_value();
+        case reply::marks_index: return _seed_marks != nullptr or _mark_index.has_value() or has_tree();
+        case reply::focus_chain: return _focus_chain.has_value() or has_tree();
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    static auto request_of(reply r) noexcept
+        -> ipc::message_type
+    {
+        switch (r) {
+        case reply::tree:
+        case reply::flat_tree:
+        case reply::marks_index:
+        case reply::focus_chain: return ipc::message_type::get_tree;
+        case reply::workspaces:  return ipc::message_type::get_workspaces;
+        case reply::outputs:     return ipc::message_type::get_outputs;
+        case reply::marks:       return ipc::message_type::get_marks;
+        }
+        return ipc::message_type::get_version;
+    }
+
+    /// Decodes a reply fetched by `prefetch` into its cache
+    void store(reply r, std::string_view payload) const
+    {
+        auto json = json::reader{payload};
+        switch (r) {
+        case reply::tree:
+        case reply::marks_index: _tree.emplace(json::read_node(json)); break;
+        case reply::flat_tree:   _flat_tree.emplace(brun::snapshot::decode(payload)); break;
+        case reply::focus_chain: _focus_chain.emplace(decode_focus_chain(payload)); break;
+        case reply::workspaces:  _workspaces.emplace(json::read_workspaces(json)); break;
+        case reply::outputs:     _outputs.emplace(json::read_outputs(json)); break;
+        case reply::marks: {
+            auto marks = std::vector<std::string>{};
+            json::read_strings(json, marks);
+            _marks.emplace(std::move(marks));
+            break;
+        }
+        }
+    }
+
+public:
+    /**
+     * Creates a context fetching everything from i3
+     *
+     * \param i3 The connection to i3, used for every request and command; it must outlive the
+     *           context, and not be subscribed to events
+     * */
+    explicit context(ipc::connection & i3) : _i3{&i3} {}
+
+    /**
+     * Creates a context detached from i3
+     * */
+    context() = default;
+
+    /**
+     * Creates a context whose tree is already known, e.g. because it is mirrored by the daemon
+     *
+     * \param i3 The connection to i3 used for everything else
+     * \param tree The current tree; it must outlive the context
+     * */
+    context(ipc::connection & i3, i3_containers::node const & tree) : _i3{&i3}, _seed{&tree} {}
+
+    /**
+     * Creates a context whose tree and marks are already known
+     *
+     * \param i3 The connection to i3 used for everything else
+     * \param tree The current tree; it must outlive the context
+     * \param marks The index of the marks of `tree`; it must outlive the context
+     * */
+    context(ipc::connection & i3, i3_containers::node const & tree, brun::mark_index const & marks)
+        : _i3{&i3}, _seed{&tree}, _seed_marks{&marks}
+    {}
+
+    /**
+     * Creates a context whose tree, marks and outputs are already known
+     *
+     * \param i3 The connection to i3 used for everything else
+     * \param tree The current tree; it must outlive the context
+     * \param marks The index of the marks of `tree`; it must outlive the context
+     * \param topology The arrangement of the outputs; it must outlive the context
+     * */
+    context(ipc::connection & i3, i3_containers::node const & tree, brun::mark_index const & marks,
+            brun::output_topology const & topology)
+        : _i3{&i3}, _seed{&tree}, _seed_marks{&marks}, _seed_topology{&topology}
+    {}
+
+    context(context const &) = delete;
+    context & operator=(context const &) = delete;
+
+    /// Check if the context is connected to i3
+    [[nodiscard]] bool is_detached() const noexcept { return _i3 == nullptr; }
+
+    /// \name Replies provided in advance, to a detached context or from the state published by the
+    ///  daemon (see `shared_state`); like the fetched ones, they are dropped by `invalidate`
+    /// \{
+    void set_tree(i3_containers::node tree) { _tree.emplace(std::move(tree)); }
+    void set_workspaces(std::vector<i3_containers::workspace> workspaces)
+    {
+        _workspace_index.reset();
+        _workspaces.emplace(std::move(workspaces));
+    }
+    void set_outputs(std::vector<i3_containers::output> outputs)
+    {
+        _output_topology.reset();
+        _outputs.emplace(std::move(outputs));
+    }
+    void set_marks(std::vector<std::string> marks) { _marks.emplace(std::move(marks)); }
+    void set_focus_chain(std::vector<chain_node> chain) { _focus_chain.emplace(std::move(chain)); }
+    void set_marks_index(brun::mark_index marks) { _mark_index.emplace(std::move(marks)); }
+    /// \}
+
+    /**
+     * Provides the history of the workspaces, kept by a process watching the events.
+     *
+     * Unlike the replies it is not dropped by `invalidate`, but it does not see the effects of the
+     * commands executed through the context either. It must outlive the context.
+     * */
+    void set_history(brun::workspace_history const & history) { _history = &history; }
+
+    /// The history of the workspaces, if the context was given one
+    [[nodiscard]] auto history() const noexcept -> brun::workspace_history const * { return _history; }
+
+    /**
+     * Tells that the owner of the context follows the events caused by its commands, e.g. the
+     * daemon, so that the operations do not wait for them on a connection of their own
+     * */
+    void set_watched() noexcept { _watched = true; }
+
+    /// Check if the events of the commands are followed by the owner of the context
+    [[nodiscard]] bool is_watched() const noexcept { return _watched; }
+
+    /**
+     * Calls `hook` right before the first command is sent to i3, e.g. to tell that the state the
+     * context was seeded with is about to be out of date; a detached context never calls it
+     * */
+    void set_before_commands(std::function<void()> hook) { _before_commands = std::move(hook); }
+
+    /// The commands that a detached context did not execute
+    [[nodiscard]] auto recorded_commands() const noexcept -> std::vector<std::string> const & { return _recorded; }
+
+    /// Moves out the commands recorded so far
+    auto take_recorded_commands() const -> std::vector<std::string> { return std::exchange(_recorded, {}); }
+
+    [[nodiscard]]
+    auto tree() const
+        -> i3_containers::node const &
+    {
+        if (_seed != nullptr) {
+            return *_seed;
+        }
+        return memoized(_tree, [this] { return brun::get_tree(connection()); });
+    }
+
+    /// Check if the whole tree is already available, without asking i3 for it
+    [[nodiscard]] bool has_tree() const noexcept { return _seed != nullptr or _tree.has_value(); }
+
+    /**
+     * Fetches the replies an operation is going to read, with a single round trip instead of one
+     * for each of them when it is first used (see `ipc::connection::request_all`).
+     *
+     * The replies already available are skipped, and a detached context has nothing to fetch; the
+     * flat tree, the index of the marks and the focus chain are not fetched if the whole tree is.
+     * Like any other reply, they are dropped by the next command.
+     * */
+    void prefetch(std::initializer_list<reply> replies) const
+    {
+        if (is_detached()) {
+            return;
+        }
+        auto wanted = std::vector<reply>{};
+        auto requests = std::vector<ipc::message_type>{};
+        for (auto const r : replies) {
+            auto const redundant = (r == reply::flat_tree or r == reply::marks_index or r == reply::focus_chain)
+                               and std::ranges::find(replies, reply::tree) != replies.end();
+            if (not is_available(r) and not redundant) {
+                wanted.push_back(r);
+                requests.push_back(request_of(r));
+            }
+        }
+        if (wanted.empty()) {
+            return;
+        }
+        auto span = trace::span{"prefetch", "context"};
+        span.arg("replies", wanted.size());
+        auto const payloads = connection().request_all(requests);
+        for (auto i = std::size_t{0}; i < wanted.size(); ++i) {
+            store(wanted[i], payloads[i]);
+        }
+    }
+
+    /**
+     * The containers from the root to the focused one, decoded from GET_TREE without
+     * materializing the rest of the tree (see `decode_focus_chain`)
+     * */
+    [[nodiscard]]
+    auto focus_chain() const
+        -> std::vector<chain_node> const &
+    {
+        return memoized(_focus_chain, [this] {
+            return decode_focus_chain(connection().request_view(ipc::message_type::get_tree));
+        });
+    }
+
+    /**
+     * The tree as a `snapshot`: built from `tree()` if the whole tree is already available,
+     * otherwise decoded directly from GET_TREE, without building the tree
+     * */
+    [[nodiscard]]
+    auto flat_tree() const
+        -> brun::snapshot const &
+    {
+        return memoized(_flat_tree, [this] {
+            if (has_tree() or is_detached()) {
+                return brun::snapshot{tree()};
+            }
+            return brun::snapshot::decode(connection().request_view(ipc::message_type::get_tree));
+        });
+    }
+
+    /// The index of the marks, built from `tree()`
+    [[nodiscard]]
+    auto marks_index() const
+        -> brun::mark_index const &
+    {
+        if (_seed_marks != nullptr) {
+            return *_seed_marks;
+        }
+        return memoized(_mark_index, [this] { return brun::mark_index{tree()}; });
+    }
+
+    [[nodiscard]]
+    auto workspaces() const
+        -> std::vector<i3_containers::workspace> const &
+    {
+        return memoized(_workspaces, [this] { return brun::get_workspaces(connection()); });
+    }
+
+    /// The index of the workspaces by number and by id, built from `workspaces()`
+    [[nodiscard]]
+    auto workspaces_index() const
+        -> brun::workspace_index const &
+    {
+        return memoized(_workspace_index, [this] { return brun::workspace_index{workspaces()}; });
+    }
+
+    [[nodiscard]]
+    auto outputs() const
+        -> std::vector<i3_containers::output> const &
+    {
+        return memoized(_outputs, [this] { return brun::get_outputs(connection()); });
+    }
+
+    /// The arrangement of the active outputs, built from `outputs()`
+    [[nodiscard]]
+    auto output_topology() const
+        -> brun::output_topology const &
+    {
+        if (_seed_topology != nullptr) {
+            return *_seed_topology;
+        }
+        return memoized(_output_topology, [this] { return brun::output_topology{outputs()}; });
+    }
+
+    [[nodiscard]]
+    auto marks() const
+        -> std::vector<std::string> const &
+    {
+        return memoized(_marks, [this] {
+            auto json = json::reader{connection().request_view(ipc::message_type::get_marks)};
+            auto marks = std::vector<std::string>{};
+            json::read_strings(json, marks);
+            return marks;
+        });
+    }
+
+    /**
+     * Drops all the memoized replies
+     * */
+    void invalidate() const
+    {
+        _seed = nullptr;
+        _seed_marks = nullptr;
+        _seed_topology = nullptr;
+        _tree.reset();
+        _flat_tree.reset();
+        _mark_index.reset();
+        _focus_chain.reset();
+        _workspace_index.reset();
+        _workspaces.reset();
+        _output_topology.reset();
+        _outputs.reset();
+        _marks.reset();
+    }
+
+    /**
+     * Runs the commands and drops the memoized replies, which could be outdated now
+     *
+     * A detached context only records them.
+     * */
+    void execute_commands(std::string const & commands) const
+    {
+        auto span = trace::span{"execute_commands", "command"};
+        span.arg("commands", commands);
+        auto const first = not std::exchange(_executed_commands, true);
+        if (is_detached()) {
+            _recorded.push_back(commands);
+            return;
+        }
+        if (first and _before_commands) {
+            _before_commands();
+        }
+        invalidate();
+        auto const replies = detail::parse_command_reply(connection().request_view(ipc::message_type::run_command, commands));
+        if (auto const failed = std::ranges::find(replies, false, &command_result::success); failed != replies.end()) {
+            fmt::print(stderr, "Command '{}' failed: {}\n", commands, failed->error);
+        }
+    }
+
+    /**
+     * Runs all the commands of the batch with a single message and drops the memoized replies.
+     *
+     * The first command that failed, if any, is reported on stderr; a detached context only
+     * records the commands.
+     * \returns The result of each command of the batch
+     * */
+    auto execute(command_batch const & batch) const
+        -> batch_result
+    {
+        if (batch.empty()) {
+            return batch_result{{}};
+        }
+        auto span = trace::span{"execute", "command"};
+        if (span.enabled()) {
+            span.arg("commands", batch.str());
+        }
+        auto const first = not std::exchange(_executed_commands, true);
+        if (is_detached()) {
+            _recorded.insert(_recorded.end(), batch.commands().begin(), batch.commands().end());
+            return batch_result{std::vector<command_result>(batch.size(), command_result{true, {}})};
+        }
+        if (first and _before_commands) {
+            _before_commands();
+        }
+        invalidate();
+        auto result = batch.submit(connection());
+        if (auto const failed = result.first_failure(); failed.has_value()) {
+            fmt::print(stderr, "Command '{}' failed: {}\n", batch.commands()[*failed], result.results()[*failed].error);
+        }
+        return result;
+    }
+
+    /**
+     * Check if any command was executed through this context
+     * */
+    [[nodiscard]] bool has_executed_commands() const noexcept { return _executed_commands; }
+};
+
+/**
+ * Connects to i3, at the socket in `I3SOCK` if it is set
+ * */
+[[nodiscard]] inline
+auto connect()
+    -> ipc::connection
+{
+    return ipc::connection{};
+}
+
+} // namespace brun
+
+#endif /* CONTEXT_HPP */
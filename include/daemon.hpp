@@ -0,0 +1,383 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : daemon
+ * @created     : Friday Oct 16, 2026 11:02:40 CEST
+ * @description : Client and server side of the protocol spoken with i3_toolsd
+ * */
+
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fmt/core.h>
+#include <tl/optional.hpp>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "detail/unique_fd.hpp"
+#include "utils.hpp"
+
+// The protocol is made of a single request and a single reply, each one in its own packet of a
+//  SOCK_SEQPACKET socket:
+//   - the request is the name of the tool followed by its `argv`, all NUL-separated; the stdout
+//     and the stderr of the client are attached to it as SCM_RIGHTS ancillary data
+//   - the reply is the exit status of the tool as an `int32_t`, or `fallback_status` if the
+//     client has to run the tool by itself
+// Neither side waits forever: a client that does not send its request in time is dropped, and a
+//  client that does not get the reply in time gives up (see `forward`).
+namespace brun::daemon
+{
+inline constexpr auto max_request_size = std::size_t{1} << 16;
+inline constexpr auto fallback_status  = std::int32_t{-1};
+/// How long the daemon waits for the request of a client that connected
+inline constexpr auto request_timeout  = std::chrono::milliseconds{100};
+/// How long a client waits for the daemon to run its tool
+inline constexpr auto reply_timeout    = std::chrono::seconds{1};
+
+/**
+ * Returns the path of the socket the daemon listens on
+ *
+ * The path can be forced with `I3_TOOLSD_SOCKET`; otherwise it is placed next to the i3 socket,
+ * so that each i3 session gets its own daemon.
+ * */
+[[nodiscard]] inline
+auto socket_path()
+    -> std::string
+{
+    if (auto const * path = std::getenv("I3_TOOLSD_SOCKET"); path != nullptr) {
+        return path;
+    }
+    if (auto const * i3sock = std::getenv("I3SOCK"); i3sock != nullptr) {
+        return fmt::format("{}.toolsd", i3sock);
+    }
+    if (auto const * runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir != nullptr) {
+        return fmt::format("{}/i3_toolsd.sock", runtime_dir);
+    }
+    return fmt::format("/tmp/i3_toolsd-{}.sock", ::getuid());
+}
+
+namespace detail
+{
+using brun::detail::unique_fd;
+
+[[nodiscard]] inline
+auto make_address(std::string_view path)
+    -> tl::optional<sockaddr_un>
+{
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return tl::nullopt;
+    }
+    std::ranges::copy(path, std::begin(address.sun_path));
+    return address;
+}
+
+[[nodiscard]] inline
+auto connect_to(std::string_view path)
+    -> unique_fd
+{
+    auto const address = make_address(path);
+    if (not address.has_value()) {
+        return {};
+    }
+    auto socket = unique_fd{::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)};
+    if (not socket) {
+        return {};
+    }
+    if (::connect(socket.get(), reinterpret_cast<sockaddr const *>(&*address), sizeof(*address)) != 0) {
+        return {};
+    }
+    return socket;
+}
+
+/// Makes the reads from `socket` fail with EAGAIN after `timeout`
+inline
+void set_receive_timeout(int socket, std::chrono::microseconds timeout) noexcept
+{
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    auto value = timeval{};
+    value.tv_sec = seconds.count();
+    value.tv_usec = (timeout - seconds).count();
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+}
+
+/// Check if the peer of `socket` closed it, e.g. because it stopped waiting
+[[nodiscard]] inline
+bool hung_up(int socket) noexcept
+{
+    auto fd = pollfd{socket, POLLRDHUP, 0};
+    return ::poll(&fd, 1, 0) > 0 and (fd.revents & (POLLRDHUP | POLLHUP)) != 0;
+}
+
+/**
+ * Temporarily replaces a standard file descriptor with another one
+ * */
+class scoped_redirect
+{
+private:
+    int _target;
+    unique_fd _saved;
+
+public:
+    scoped_redirect(int replacement, int target) : _target{target}
+    {
+        if (replacement >= 0) {
+            std::fflush(target == STDOUT_FILENO ? stdout : stderr);
+            _saved.reset(::dup(target));
+            ::dup2(replacement, target);
+        }
+    }
+    scoped_redirect(scoped_redirect const &) = delete;
+    scoped_redirect & operator=(scoped_redirect const &) = delete;
+    ~scoped_redirect()
+    {
+        if (_saved) {
+            std::fflush(_target == STDOUT_FILENO ? stdout : stderr);
+            ::dup2(_saved.get(), _target);
+        }
+    }
+};
+} // namespace detail
+
+
+/**
+ * Asks the daemon to run a tool on behalf of the current process
+ *
+ * \param tool The name of the tool
+ * \param args The `argv` of the current process
+ * If the daemon does not reply within `reply_timeout` the client gives up with status 255, without
+ * running the tool directly: the request could have been applied already, and running it again
+ * would apply it twice. The daemon skips the requests whose client gave up before they were run.
+ *
+ * \returns An optional containing the exit status of the tool, or an empty optional if the daemon
+ *          is not available and the tool must be run directly
+ * */
+[[nodiscard]] inline
+auto forward(std::string_view tool, std::span<char const * const> args)
+    -> tl::optional<int>
+{
+    if (std::getenv("I3_TOOLS_NO_DAEMON") != nullptr) {
+        return tl::nullopt;
+    }
+    auto const socket = detail::connect_to(socket_path());
+    if (not socket) {
+        return tl::nullopt;
+    }
+
+    auto payload = std::string{tool};
+    for (auto const * arg : args) {
+        payload.push_back('\0');
+        payload.append(arg);
+    }
+    if (payload.size() > max_request_size) {
+        return tl::nullopt;
+    }
+
+    auto const fds = std::array{STDOUT_FILENO, STDERR_FILENO};
+    alignas(cmsghdr) auto control = std::array<char, CMSG_SPACE(sizeof(fds))>{};
+    auto iov = iovec{payload.data(), payload.size()};
+    auto message = msghdr{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    auto * const header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(header), fds.data(), sizeof(fds));
+
+    if (::sendmsg(socket.get(), &message, MSG_NOSIGNAL) < 0) {
+        return tl::nullopt;
+    }
+
+    auto status = std::int32_t{};
+    detail::set_receive_timeout(socket.get(), reply_timeout);
+    if (::recv(socket.get(), &status, sizeof(status), 0) != sizeof(status)) {
+        // The request was delivered, so running the tool again could apply it twice
+        fmt::print(stderr, "i3_toolsd did not reply to the request within {} ms\n",
+                   std::chrono::milliseconds{reply_timeout}.count());
+        return 255;
+    }
+    if (status == fallback_status) {
+        return tl::nullopt;
+    }
+    return status;
+}
+
+
+/**
+ * A request received by the daemon
+ * */
+struct request
+{
+    std::string_view tool;
+    std::vector<char const *> args;
+    detail::unique_fd out;
+    detail::unique_fd err;
+};
+
+/**
+ * Replaces the stdout and the stderr of the daemon with the ones of the client of a request, until
+ * it is destroyed.
+ *
+ * The replacement is seen by the whole process: it must only be in place while the other threads
+ * cannot write, e.g. while holding the lock they take before writing, so that the diagnostics of
+ * the daemon do not end up on the terminal of a client.
+ * */
+class client_output
+{
+private:
+    detail::scoped_redirect _out;
+    detail::scoped_redirect _err;
+
+public:
+    explicit client_output(request const & req)
+        : _out{req.out.get(), STDOUT_FILENO}, _err{req.err.get(), STDERR_FILENO}
+    {}
+};
+
+/**
+ * The listening side of the daemon
+ * */
+class server
+{
+private:
+    std::string _path;
+    detail::unique_fd _socket;
+
+    [[nodiscard]] static
+    auto receive(int client, std::vector<char> & buffer)
+        -> tl::optional<request>
+    {
+        auto fds = std::array{-1, -1};
+        alignas(cmsghdr) auto control = std::array<char, CMSG_SPACE(sizeof(fds))>{};
+        auto iov = iovec{buffer.data(), buffer.size() - 1};
+        auto message = msghdr{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+
+        auto const received = ::recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+        if (received <= 0 or (message.msg_flags & MSG_TRUNC) != 0) {
+            return tl::nullopt;
+        }
+        for (auto * header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET and header->cmsg_type == SCM_RIGHTS
+                    and header->cmsg_len == CMSG_LEN(sizeof(fds))) {
+                std::memcpy(fds.data(), CMSG_DATA(header), sizeof(fds));
+            }
+        }
+
+        auto req = request{};
+        req.out.reset(fds[0]);
+        req.err.reset(fds[1]);
+        buffer[static_cast<std::size_t>(received)] = '\0';
+        auto const payload = std::string_view{buffer.data(), static_cast<std::size_t>(received)};
+        auto const tool_end = payload.find('\0');
+        req.tool = payload.substr(0, tool_end);
+        for (auto pos = tool_end; pos != std::string_view::npos; pos = payload.find('\0', pos + 1)) {
+            req.args.push_back(payload.data() + pos + 1);
+        }
+        return req;
+    }
+
+public:
+    /**
+     * Starts listening on `path`
+     *
+     * A stale socket left by a dead daemon is replaced, while a live one makes the constructor fail.
+     * */
+    explicit server(std::string path) : _path{std::move(path)}
+    {
+        auto const address = detail::make_address(_path);
+        if (not address.has_value()) {
+            throw std::system_error{ENAMETOOLONG, std::generic_category(), _path};
+        }
+        if (detail::connect_to(_path)) {
+            throw std::system_error{EADDRINUSE, std::generic_category(), "i3_toolsd is already running"};
+        }
+        ::unlink(_path.c_str());
+
+        _socket.reset(::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+        if (not _socket
+                or ::bind(_socket.get(), reinterpret_cast<sockaddr const *>(&*address), sizeof(*address)) != 0
+                or ::listen(_socket.get(), 16) != 0) {
+            throw std::system_error{errno, std::generic_category(), _path};
+        }
+    }
+    server(server const &) = delete;
+    server & operator=(server const &) = delete;
+    ~server() { ::unlink(_path.c_str()); }
+
+    /**
+     * Makes `serve` return, can be called from any thread
+     * */
+    void shutdown() noexcept { ::shutdown(_socket.get(), SHUT_RDWR); }
+
+    /**
+     * Serves the requests one at a time until `shutdown` is called
+     *
+     * \param handler Invoked for each request, returns the exit status of the tool; it shows the
+     *                output of the tool to the client with `client_output`, and the exceptions it
+     *                throws are reported on the stderr of the client
+     * */
+    template <typename Handler>
+    void serve(Handler && handler)
+    {
+        auto buffer = std::vector<char>(max_request_size + 1);
+        while (true) {
+            auto const client = detail::unique_fd{::accept4(_socket.get(), nullptr, nullptr, SOCK_CLOEXEC)};
+            if (not client) {
+                if (errno == EINTR or errno == ECONNABORTED) {
+                    continue;
+                }
+                return;
+            }
+            detail::set_receive_timeout(client.get(), request_timeout);
+            auto req = receive(client.get(), buffer);
+            if (not req.has_value()) {
+                continue;
+            }
+            // Queued while the daemon was busy, by a client that stopped waiting for it
+            if (detail::hung_up(client.get())) {
+                brun::log("Client of {} gone before its request was served\n", req->tool);
+                continue;
+            }
+
+            auto const status = [&] {
+                try {
+                    return static_cast<std::int32_t>(handler(*req));
+                }
+                catch (std::exception const & exc) {
+                    auto const error = fmt::format("Got exception: {}\n", exc.what());
+                    [[maybe_unused]] auto const written = ::write(req->err ? req->err.get() : STDERR_FILENO,
+                                                                  error.data(), error.size());
+                    return std::int32_t{255};
+                }
+            }();
+            brun::log("{} exited with status {}\n", req->tool, status);
+            ::send(client.get(), &status, sizeof(status), MSG_NOSIGNAL);
+        }
+    }
+};
+} // namespace brun::daemon
+
+#endif /* DAEMON_HPP */
@@ -0,0 +1,337 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : i3_json
+ * @created     : Friday Oct 16, 2026 21:24:40 CEST
+ * @license     : MIT
+ * @description : Decoding of the values found in the JSON replies of i3
+ * */
+
+#ifndef DETAIL_I3_JSON_HPP
+#define DETAIL_I3_JSON_HPP
+
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+
+#include "json.hpp"
+
+namespace brun::json
+{
+[[nodiscard]] inline
+auto read_node_type(reader & json)
+    -> i3_containers::node_type
+{
+    using i3_containers::node_type;
+    auto const type = json.read_raw_string();
+    if (type == "con")          { return node_type::con; }
+    if (type == "workspace")    { return node_type::workspace; }
+    if (type == "output")       { return node_type::output; }
+    if (type == "floating_con") { return node_type::floating_con; }
+    if (type == "dockarea")     { return node_type::dockarea; }
+    return node_type::root;
+}
+
+[[nodiscard]] inline
+auto read_node_layout(reader & json)
+    -> i3_containers::node_layout
+{
+    using i3_containers::node_layout;
+    auto const layout = json.read_raw_string();
+    if (layout == "splitv")   { return node_layout::splitv; }
+    if (layout == "stacked")  { return node_layout::stacked; }
+    if (layout == "tabbed")   { return node_layout::tabbed; }
+    if (layout == "dockarea") { return node_layout::dockarea; }
+    if (layout == "output")   { return node_layout::output; }
+    return node_layout::splith;
+}
+
+[[nodiscard]] inline
+auto read_fullscreen_mode(reader & json)
+    -> i3_containers::fullscreen_mode_type
+{
+    using i3_containers::fullscreen_mode_type;
+    switch (json.read_number<int>()) {
+    case 1:  return fullscreen_mode_type::fullscreen;
+    case 2:  return fullscreen_mode_type::global_fullscreen;
+    default: return fullscreen_mode_type::no_fullscreen;
+    }
+}
+/// Reads an object with the fields x, y, width and height
+inline
+void read_rect(reader & json, auto & rect)
+{
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "x") {
+            rect.x = json.read_number<decltype(rect.x)>();
+        }
+        else if (*key == "y") {
+            rect.y = json.read_number<decltype(rect.y)>();
+        }
+        else if (*key == "width") {
+            rect.width = json.read_number<decltype(rect.width)>();
+        }
+        else if (*key == "height") {
+            rect.height = json.read_number<decltype(rect.height)>();
+        }
+        else {
+            json.skip_value();
+        }
+    }
+}
+
+/**
+ * Reads an array of strings
+ * */
+inline
+void read_strings(reader & json, std::vector<std::string> & out)
+{
+    json.begin_array();
+    while (json.next_element()) {
+        out.push_back(json.read_string());
+    }
+}
+
+/**
+ * Reads a whole container, with all its descendants, as sent by GET_TREE
+ * */
+[[nodiscard]] inline
+auto read_node(reader & json)
+    -> i3_containers::node
+{
+    auto node = i3_containers::node{};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "id") {
+            node.id = json.read_number<uint64_t>();
+        }
+        else if (*key == "type") {
+            node.type = read_node_type(json);
+        }
+        else if (*key == "layout") {
+            node.layout = read_node_layout(json);
+        }
+        else if (*key == "rect") {
+            read_rect(json, node.rect);
+        }
+        else if (*key == "name") {
+            if (not json.read_null()) {
+                node.name = json.read_string();
+            }
+        }
+        else if (*key == "focused") {
+            node.is_focused = json.read_bool();
+        }
+        else if (*key == "fullscreen_mode") {
+            node.fullscreen_mode = read_fullscreen_mode(json);
+        }
+        else if (*key == "marks") {
+            read_strings(json, node.marks);
+        }
+        else if (*key == "focus") {
+            json.begin_array();
+            while (json.next_element()) {
+                node.focus.push_back(json.read_number<uint64_t>());
+            }
+        }
+        else if (*key == "nodes" or *key == "floating_nodes") {
+            auto & children = *key == "nodes" ? node.nodes : node.floating_nodes;
+            json.begin_array();
+            while (json.next_element()) {
+                children.push_back(read_node(json));
+            }
+        }
+        else {
+            json.skip_value();
+        }
+    }
+    return node;
+}
+
+/**
+ * Reads the reply to GET_WORKSPACES
+ * */
+[[nodiscard]] inline
+auto read_workspaces(reader & json)
+    -> std::vector<i3_containers::workspace>
+{
+    auto workspaces = std::vector<i3_containers::workspace>{};
+    json.begin_array();
+    while (json.next_element()) {
+        auto & ws = workspaces.emplace_back();
+        json.begin_object();
+        while (auto const key = json.next_key()) {
+            if (*key == "id") {
+                ws.id = json.read_number<uint64_t>();
+            }
+            else if (*key == "num") {
+                // i3 sends -1 for the workspaces without a number
+                if (auto const num = json.read_number<int>(); num >= 0) {
+                    ws.num = num;
+                }
+            }
+            else if (*key == "name") {
+                ws.name = json.read_string();
+            }
+            else if (*key == "visible") {
+                ws.is_visible = json.read_bool();
+            }
+            else if (*key == "focused") {
+                ws.is_focused = json.read_bool();
+            }
+            else if (*key == "urgent") {
+                ws.is_urgent = json.read_bool();
+            }
+            else if (*key == "rect") {
+                read_rect(json, ws.rect);
+            }
+            else if (*key == "output") {
+                ws.output = json.read_string();
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+    return workspaces;
+}
+
+/**
+ * Reads the reply to GET_OUTPUTS
+ * */
+[[nodiscard]] inline
+auto read_outputs(reader & json)
+    -> std::vector<i3_containers::output>
+{
+    auto outputs = std::vector<i3_containers::output>{};
+    json.begin_array();
+    while (json.next_element()) {
+        auto & output = outputs.emplace_back();
+        json.begin_object();
+        while (auto const key = json.next_key()) {
+            if (*key == "name") {
+                output.name = json.read_string();
+            }
+            else if (*key == "active") {
+                output.is_active = json.read_bool();
+            }
+            else if (*key == "primary") {
+                output.is_primary = json.read_bool();
+            }
+            else if (*key == "current_workspace") {
+                if (not json.read_null()) {
+                    output.current_workspace = json.read_string();
+                }
+            }
+            else if (*key == "rect") {
+                read_rect(json, output.rect);
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+    return outputs;
+}
+
+/// The change of the events not known here (e.g. added by a newer i3), which say nothing about what changed
+template <typename Change>
+inline constexpr auto unknown_change = static_cast<Change>(std::numeric_limits<std::underlying_type_t<Change>>::max());
+
+/**
+ * \returns The change of a window event, or `unknown_change` for the ones not known here
+ * */
+[[nodiscard]] inline
+auto read_window_change(reader & json)
+    -> i3_containers::window_change
+{
+    using i3_containers::window_change;
+    auto const change = json.read_raw_string();
+    if (change == "new")             { return window_change::create; }
+    if (change == "close")           { return window_change::close; }
+    if (change == "title")           { return window_change::title; }
+    if (change == "fullscreen_mode") { return window_change::fullscreen_mode; }
+    if (change == "move")            { return window_change::move; }
+    if (change == "floating")        { return window_change::floating; }
+    if (change == "urgent")          { return window_change::urgent; }
+    if (change == "mark")            { return window_change::mark; }
+    if (change == "focus")           { return window_change::focus; }
+    return unknown_change<window_change>;
+}
+
+/**
+ * Reads the payload of a window event
+ * */
+[[nodiscard]] inline
+auto read_window_event(reader & json)
+    -> i3_containers::window_event
+{
+    auto event = i3_containers::window_event{};
+    event.change = unknown_change<i3_containers::window_change>;
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "change") {
+            event.change = read_window_change(json);
+        }
+        else if (*key == "container") {
+            event.container = read_node(json);
+        }
+        else {
+            json.skip_value();
+        }
+    }
+    return event;
+}
+
+/**
+ * \returns The change of a workspace event, or `unknown_change` for the ones not known here
+ * */
+[[nodiscard]] inline
+auto read_workspace_change(reader & json)
+    -> i3_containers::workspace_change
+{
+    using i3_containers::workspace_change;
+    auto const change = json.read_raw_string();
+    if (change == "init")     { return workspace_change::init; }
+    if (change == "empty")    { return workspace_change::empty; }
+    if (change == "urgent")   { return workspace_change::urgent; }
+    if (change == "rename")   { return workspace_change::rename; }
+    if (change == "reload")   { return workspace_change::reload; }
+    if (change == "restored") { return workspace_change::restored; }
+    if (change == "move")     { return workspace_change::move; }
+    if (change == "focus")    { return workspace_change::focus; }
+    return unknown_change<workspace_change>;
+}
+
+/**
+ * Reads the payload of a workspace event
+ * */
+[[nodiscard]] inline
+auto read_workspace_event(reader & json)
+    -> i3_containers::workspace_event
+{
+    auto event = i3_containers::workspace_event{};
+    event.change = unknown_change<i3_containers::workspace_change>;
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "change") {
+            event.change = read_workspace_change(json);
+        }
+        else if (*key == "current" or *key == "old") {
+            auto & target = *key == "current" ? event.current : event.old;
+            if (not json.read_null()) {
+                target = read_node(json);
+            }
+        }
+        else {
+            json.skip_value();
+        }
+    }
+    return event;
+}
+} // namespace brun::json
+
+#endif /* DETAIL_I3_JSON_HPP */
@@ -0,0 +1,356 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : json
+ * @created     : Friday Oct 16, 2026 17:40:02 CEST
+ * @license     : MIT
+ * @description : Minimal pull parser for the JSON sent by i3
+ * */
+
+#ifndef DETAIL_JSON_HPP
+#define DETAIL_JSON_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fmt/core.h>
+#include <tl/optional.hpp>
+
+namespace brun::json
+{
+class parse_error : public std::runtime_error
+{
+public:
+    parse_error(std::string_view what, std::size_t position)
+        : std::runtime_error{fmt::format("JSON parse error at {}: {}", position, what)}
+    {}
+};
+
+/**
+ * Reads a JSON document one token at a time, without building any intermediate representation.
+ *
+ * Objects are read with `begin_object` followed by `next_key` until it returns an empty optional,
+ * reading (or skipping) the value after each key; arrays in the same way with `begin_array` and
+ * `next_element`. Skipping a value never allocates.
+ * */
+class reader
+{
+private:
+    std::string_view _text;
+    std::size_t _pos = 0;
+
+    [[noreturn]] void fail(std::string_view what) const { throw parse_error{what, _pos}; }
+
+    /// Skips a string, `_pos` must be on the opening quote
+    void skip_string()
+    {
+        ++_pos;
+        while (true) {
+            auto const end = _text.find_first_of("\"\\", _pos);
+            if (end == std::string_view::npos) {
+                fail("unterminated string");
+            }
+            if (_text[end] == '"') {
+                _pos = end + 1;
+                return;
+            }
+            _pos = end + 2;
+        }
+    }
+
+    static void append_utf8(auto & out, std::uint32_t code)
+    {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    auto read_hex4()
+        -> std::uint32_t
+    {
+        auto code = std::uint32_t{};
+        auto const [ptr, ec] = std::from_chars(_text.data() + _pos, _text.data() + std::min(_pos + 4, _text.size()), code, 16);
+        if (ec != std::errc{} or ptr != _text.data() + _pos + 4) {
+            fail("bad unicode escape");
+        }
+        _pos += 4;
+        return code;
+    }
+
+public:
+    explicit reader(std::string_view text) noexcept : _text{text} {}
+
+    [[nodiscard]] auto position() const noexcept { return _pos; }
+    [[nodiscard]] auto text() const noexcept { return _text; }
+
+    /// Moves to an offset previously obtained with `position`
+    void seek(std::size_t position) noexcept { _pos = position; }
+
+    void skip_whitespace() noexcept
+    {
+        while (_pos < _text.size()
+                and (_text[_pos] == ' ' or _text[_pos] == '\n' or _text[_pos] == '\r' or _text[_pos] == '\t')) {
+            ++_pos;
+        }
+    }
+
+    [[nodiscard]]
+    auto peek()
+        -> char
+    {
+        skip_whitespace();
+        if (_pos >= _text.size()) {
+            fail("unexpected end of input");
+        }
+        return _text[_pos];
+    }
+
+    [[nodiscard]]
+    bool at_end() noexcept
+    {
+        skip_whitespace();
+        return _pos >= _text.size();
+    }
+
+    /// Consumes `c` if it is the next character
+    bool consume(char c)
+    {
+        if (peek() == c) {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (not consume(c)) {
+            fail(fmt::format("expected '{}'", c));
+        }
+    }
+
+    void begin_object() { expect('{'); }
+    void begin_array()  { expect('['); }
+
+    /**
+     * Reads the next key of the current object, consuming the ':' after it
+     *
+     * \returns The key, or an empty optional when the object is over
+     * */
+    [[nodiscard]]
+    auto next_key()
+        -> tl::optional<std::string_view>
+    {
+        if (consume('}')) {
+            return tl::nullopt;
+        }
+        consume(',');
+        auto const key = read_raw_string();
+        expect(':');
+        return key;
+    }
+
+    /**
+     * Moves to the next element of the current array
+     *
+     * \returns `false` when the array is over
+     * */
+    [[nodiscard]]
+    bool next_element()
+    {
+        if (consume(']')) {
+            return false;
+        }
+        consume(',');
+        return true;
+    }
+
+    /**
+     * Reads a string without unescaping it; meant for keys and other strings known to be plain
+     * */
+    [[nodiscard]]
+    auto read_raw_string()
+        -> std::string_view
+    {
+        if (peek() != '"') {
+            fail("expected a string");
+        }
+        auto const begin = _pos + 1;
+        skip_string();
+        return _text.substr(begin, _pos - begin - 1);
+    }
+
+    [[nodiscard]]
+    auto read_string()
+        -> std::string
+    {
+        auto result = std::string{};
+        read_string(result);
+        return result;
+    }
+
+    /// Reads and unescapes a string, appending it to `out`
+    void read_string(auto & out)
+    {
+        if (peek() != '"') {
+            fail("expected a string");
+        }
+        ++_pos;
+        while (true) {
+            auto const end = _text.find_first_of("\"\\", _pos);
+            if (end == std::string_view::npos) {
+                fail("unterminated string");
+            }
+            out.append(_text.data() + _pos, end - _pos);
+            _pos = end + 1;
+            if (_text[end] == '"') {
+                return;
+            }
+            if (_pos >= _text.size()) {
+                fail("unterminated string");
+            }
+            switch (auto const escaped = _text[_pos++]) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                auto code = read_hex4();
+                if (code >= 0xD800 and code < 0xDC00 and _text.substr(_pos, 2) == "\\u") {
+                    _pos += 2;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (read_hex4() - 0xDC00);
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default: out.push_back(escaped); break;
+            }
+        }
+    }
+
+    [[nodiscard]]
+    bool read_bool()
+    {
+        if (peek() == 't' and _text.substr(_pos, 4) == "true") {
+            _pos += 4;
+            return true;
+        }
+        if (_text.substr(_pos, 5) == "false") {
+            _pos += 5;
+            return false;
+        }
+        fail("expected a boolean");
+    }
+
+    /// Consumes a `null` if it is the next value
+    bool read_null()
+    {
+        if (peek() == 'n' and _text.substr(_pos, 4) == "null") {
+            _pos += 4;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+        requires std::integral<T> or std::floating_point<T>
+    [[nodiscard]]
+    auto read_number()
+        -> T
+    {
+        skip_whitespace();
+        auto value = T{};
+        auto const * const begin = _text.data() + _pos;
+        auto const [ptr, ec] = std::from_chars(begin, _text.data() + _text.size(), value);
+        if (ec != std::errc{}) {
+            // i3 sends some integers as doubles (e.g. percent) and ids as unsigned 64 bit
+            if constexpr (std::integral<T>) {
+                // Converted only if its integral part fits, e.g. not a negative value for an id
+                constexpr auto bound = static_cast<double>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+                constexpr auto lowest = std::numeric_limits<T>::is_signed ? -bound : 0.0;
+                auto const whole = std::trunc(read_number<double>());
+                if (not (whole >= lowest and whole < bound)) {
+                    fail("expected a number");
+                }
+                return static_cast<T>(whole);
+            }
+            fail("expected a number");
+        }
+        _pos += static_cast<std::size_t>(ptr - begin);
+        if constexpr (std::integral<T>) {
+            // skip the fractional part, if any
+            constexpr auto fraction_chars = std::string_view{".eE+-0123456789"};
+            while (_pos < _text.size() and fraction_chars.find(_text[_pos]) != std::string_view::npos) {
+                ++_pos;
+            }
+        }
+        return value;
+    }
+
+    /**
+     * Skips the next value, whatever it is, without allocating
+     * */
+    void skip_value()
+    {
+        auto const c = peek();
+        if (c == '"') {
+            return skip_string();
+        }
+        if (c == '{' or c == '[') {
+            auto depth = 0;
+            do {
+                auto const next = _text.find_first_of("\"{}[]", _pos);
+                if (next == std::string_view::npos) {
+                    fail("unterminated value");
+                }
+                _pos = next;
+                switch (_text[next]) {
+                case '"': skip_string(); continue;
+                case '{': case '[': ++depth; break;
+                default: --depth; break;
+                }
+                ++_pos;
+            } while (depth > 0);
+            return;
+        }
+        auto const end = _text.find_first_of(",}] \t\r\n", _pos);
+        _pos = end == std::string_view::npos ? _text.size() : end;
+    }
+
+    /**
+     * Skips the next value and returns the text it spans
+     * */
+    [[nodiscard]]
+    auto raw_value()
+        -> std::string_view
+    {
+        skip_whitespace();
+        auto const begin = _pos;
+        skip_value();
+        return _text.substr(begin, _pos - begin);
+    }
+};
+} // namespace brun::json
+
+#endif /* DETAIL_JSON_HPP */
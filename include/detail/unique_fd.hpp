@@ -0,0 +1,53 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : unique_fd
+ * @created     : Friday Oct 16, 2026 10:02:11 CEST
+ * @license     : MIT
+ * */
+
+#ifndef DETAIL_UNIQUE_FD_HPP
+#define DETAIL_UNIQUE_FD_HPP
+
+#include <utility>
+#include <unistd.h>
+
+namespace brun::detail
+{
+/**
+ * Owning wrapper around a file descriptor, closed on destruction
+ * */
+class unique_fd
+{
+private:
+    int _fd = -1;
+
+public:
+    unique_fd() = default;
+    explicit unique_fd(int fd) : _fd{fd} {}
+    unique_fd(unique_fd && other) noexcept : _fd{std::exchange(other._fd, -1)} {}
+    unique_fd & operator=(unique_fd && other) noexcept
+    {
+        if (this != &other) {
+            reset(std::exchange(other._fd, -1));
+        }
+        return *this;
+    }
+    unique_fd(unique_fd const &) = delete;
+    unique_fd & operator=(unique_fd const &) = delete;
+    ~unique_fd() { reset(); }
+
+    [[nodiscard]] int get() const noexcept { return _fd; }
+    [[nodiscard]] explicit operator bool() const noexcept { return _fd >= 0; }
+
+    [[nodiscard]] int release() noexcept { return std::exchange(_fd, -1); }
+    void reset(int fd = -1) noexcept
+    {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+        _fd = fd;
+    }
+};
+} // namespace brun::detail
+
+#endif /* DETAIL_UNIQUE_FD_HPP */
@@ -0,0 +1,216 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : event_loop
+ * @created     : Saturday Oct 17, 2026 10:05:16 CEST
+ * @description : Single-threaded loop waiting on file descriptors and timers with epoll
+ * */
+
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "detail/unique_fd.hpp"
+
+namespace brun
+{
+/**
+ * Waits for file descriptors to become readable and calls their handlers, one at a time.
+ *
+ * The loop sleeps in `epoll_wait` without a timeout, so it uses no CPU while nothing happens;
+ * timers are file descriptors too (see `timer`).
+ * */
+class event_loop
+{
+private:
+    detail::unique_fd _epoll;
+    std::map<int, std::function<void()>> _handlers;
+    // Handlers removed while the loop is dispatching, kept alive until the dispatch is over since
+    //  one of them could be the handler being run
+    std::vector<std::function<void()>> _removed;
+    std::atomic<bool> _stopped = false;
+    detail::unique_fd _wake;    // eventfd written by `stop`, to interrupt `epoll_wait`
+
+public:
+    event_loop()
+        : _epoll{::epoll_create1(EPOLL_CLOEXEC)}
+        , _wake{::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+    {
+        if (not _epoll or not _wake) {
+            throw std::system_error{errno, std::generic_category(), "event loop"};
+        }
+        auto event = epoll_event{};
+        event.events = EPOLLIN;
+        event.data.fd = _wake.get();
+        if (::epoll_ctl(_epoll.get(), EPOLL_CTL_ADD, _wake.get(), &event) != 0) {
+            throw std::system_error{errno, std::generic_category(), "epoll_ctl"};
+        }
+    }
+
+    event_loop(event_loop const &) = delete;
+    event_loop & operator=(event_loop const &) = delete;
+
+    /**
+     * Calls `on_readable` every time `fd` can be read, until `unwatch` is called for it.
+     *
+     * The loop is level-triggered: a handler which does not consume all the data is called again.
+     * */
+    void watch(int fd, std::function<void()> on_readable)
+    {
+        auto event = epoll_event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(_epoll.get(), EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw std::system_error{errno, std::generic_category(), "epoll_ctl"};
+        }
+        _handlers[fd] = std::move(on_readable);
+    }
+
+    void unwatch(int fd) noexcept
+    {
+        if (auto const found = _handlers.find(fd); found != _handlers.end()) {
+            ::epoll_ctl(_epoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+            _removed.push_back(std::move(found->second));
+            _handlers.erase(found);
+        }
+    }
+
+    /**
+     * Makes `run` return once the current handler is done.
+     *
+     * Can be called from a handler, from another thread or from a signal handler.
+     * */
+    void stop() noexcept
+    {
+        _stopped = true;
+        auto const one = std::uint64_t{1};
+        [[maybe_unused]] auto const written = ::write(_wake.get(), &one, sizeof(one));
+    }
+
+    /**
+     * Dispatches the events until `stop` is called or there is nothing left to watch.
+     *
+     * The exceptions thrown by the handlers are propagated, leaving the loop.
+     * */
+    void run()
+    {
+        auto ready = std::array<epoll_event, 16>{};
+        while (not _stopped and not _handlers.empty()) {
+            auto const count = ::epoll_wait(_epoll.get(), ready.data(), static_cast<int>(ready.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::generic_category(), "epoll_wait"};
+            }
+            for (auto i = 0; i < count and not _stopped; ++i) {
+                // A previous handler of this batch could have removed this one
+                if (auto const found = _handlers.find(ready[static_cast<std::size_t>(i)].data.fd); found != _handlers.end()) {
+                    found->second();
+                }
+            }
+            _removed.clear();
+        }
+        // Ready for the next `run`
+        auto count = std::uint64_t{};
+        [[maybe_unused]] auto const received = ::read(_wake.get(), &count, sizeof(count));
+        _stopped = false;
+    }
+};
+
+/**
+ * A one-shot timer running its callback in an `event_loop`.
+ *
+ * Arming it again before it expires postpones the expiration, which is what a debounce needs. It
+ * can be armed and cancelled from other threads too.
+ * */
+class timer
+{
+private:
+    event_loop & _loop;
+    detail::unique_fd _fd;
+    std::function<void()> _on_expire;
+    std::atomic<bool> _armed = false;
+
+    void set(std::chrono::nanoseconds value, int flags = 0)
+    {
+        auto spec = itimerspec{};
+        auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(value);
+        spec.it_value.tv_sec = seconds.count();
+        spec.it_value.tv_nsec = (value - seconds).count();
+        if (::timerfd_settime(_fd.get(), flags, &spec, nullptr) != 0) {
+            throw std::system_error{errno, std::generic_category(), "timerfd_settime"};
+        }
+    }
+
+public:
+    timer(event_loop & loop, std::function<void()> on_expire)
+        : _loop{loop}
+        , _fd{::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)}
+        , _on_expire{std::move(on_expire)}
+    {
+        if (not _fd) {
+            throw std::system_error{errno, std::generic_category(), "timerfd_create"};
+        }
+        _loop.watch(_fd.get(), [this] {
+            auto expirations = std::uint64_t{};
+            if (::read(_fd.get(), &expirations, sizeof(expirations)) != static_cast<ssize_t>(sizeof(expirations))) {
+                return;     // disarmed after being marked as readable
+            }
+            _armed = false;
+            _on_expire();
+        });
+    }
+
+    timer(timer const &) = delete;
+    timer & operator=(timer const &) = delete;
+
+    ~timer() { _loop.unwatch(_fd.get()); }
+
+    /**
+     * Makes the timer expire `after` from now, replacing the previous expiration if any
+     * */
+    void arm(std::chrono::nanoseconds after)
+    {
+        // A zero `it_value` would disarm the timer
+        set(std::max(after, std::chrono::nanoseconds{1}));
+        _armed = true;
+    }
+
+    /**
+     * Makes the timer expire at `deadline`, or as soon as possible if it is already past
+     * */
+    void arm(std::chrono::steady_clock::time_point deadline)
+    {
+        // steady_clock is CLOCK_MONOTONIC, like the timer
+        auto const since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+        set(std::max(since_epoch, std::chrono::nanoseconds{1}), TFD_TIMER_ABSTIME);
+        _armed = true;
+    }
+
+    void cancel()
+    {
+        set(std::chrono::nanoseconds{0});
+        _armed = false;
+    }
+
+    [[nodiscard]] bool armed() const noexcept { return _armed; }
+};
+} // namespace brun
+
+#endif /* EVENT_LOOP_HPP */
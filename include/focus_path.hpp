@@ -0,0 +1,176 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : focus_path
+ * @created     : Friday Oct 16, 2026 20:58:14 CEST
+ * @description : Everything about the focused container, collected with one walk of the tree
+ * */
+
+#ifndef FOCUS_PATH_HPP
+#define FOCUS_PATH_HPP
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "context.hpp"
+#include "lazy_tree.hpp"
+#include "marks.hpp"
+#include "nodes.hpp"
+#include "trace.hpp"
+
+namespace brun
+{
+
+/**
+ * The focused container and the containers enclosing it
+ * */
+struct focus_path
+{
+    uint64_t focused;
+    i3_containers::fullscreen_mode_type fullscreen_mode;
+    border position;                 // the borders of the workspace the container is on
+    uint64_t workspace;
+    tl::optional<int> workspace_num;
+    std::string output;
+
+    [[nodiscard]] bool is_fullscreen() const noexcept
+    { return fullscreen_mode != i3_containers::fullscreen_mode_type::no_fullscreen; }
+};
+
+/**
+ * Follows the focus from the root down to the focused container, computing at the same time its
+ * border, its workspace and its output.
+ *
+ * This replaces `focused_node`, `node_on_border`, `focused_workspace` and `retrieve_output_names`
+ * when all of them are needed, so that a single tree is fetched and walked only once.
+ * \param root The root of the tree
+ * \returns The focus path, or an empty optional if the focused container was not found
+ * */
+[[nodiscard]] inline
+auto analyze_focus(i3_containers::node const & root)
+    -> tl::optional<focus_path>
+{
+    using i3_containers::node_type;
+    auto const span = trace::span{"analyze_focus", "tree"};
+    auto result = focus_path{};
+    auto on_border = border::unique;
+    auto const * node = &root;
+    while (true) {
+        if (node->type == node_type::output) {
+            result.output = node->name.value_or("");
+        }
+        else if (node->type == node_type::workspace) {
+            result.workspace = node->id;
+            result.workspace_num = detail::workspace_num(node->name);
+        }
+
+        if (node->is_focused) {
+            result.focused = node->id;
+            result.fullscreen_mode = node->fullscreen_mode;
+            result.position = on_border;
+            return result;
+        }
+        if (node->focus.empty()) {
+            return tl::nullopt;
+        }
+
+        auto const focused_id = node->focus.front();
+        auto const & tiling = node->nodes;
+        auto child = std::ranges::find(tiling, focused_id, &i3_containers::node::id);
+        auto const is_tiling = child != tiling.end();
+        if (not is_tiling) {
+            child = std::ranges::find(node->floating_nodes, focused_id, &i3_containers::node::id);
+            if (child == node->floating_nodes.end()) {
+                return tl::nullopt;
+            }
+        }
+
+        auto const vertical_layout = node->layout == i3_containers::node_layout::splitv
+                                  or node->layout == i3_containers::node_layout::stacked;
+        auto const is_first = is_tiling and child == tiling.begin();
+        auto const is_last  = is_tiling and std::next(child) == tiling.end();
+        on_border = detail::child_border(on_border, vertical_layout, is_first, is_last, child->type);
+        node = &*child;
+    }
+}
+
+/**
+ * Computes the focus path from the containers decoded by `decode_focus_chain`
+ *
+ * \param chain The containers from the root to the focused one
+ * \returns The focus path, or an empty optional if the focused container was not found
+ * */
+[[nodiscard]] inline
+auto analyze_focus(std::span<chain_node const> chain)
+    -> tl::optional<focus_path>
+{
+    using i3_containers::node_type;
+    auto result = focus_path{};
+    auto on_border = border::unique;
+    for (auto i = std::size_t{0}; i < chain.size(); ++i) {
+        auto const & node = chain[i];
+        if (i != 0) {
+            auto const & parent = chain[i - 1];
+            auto const vertical_layout = parent.layout == i3_containers::node_layout::splitv
+                                      or parent.layout == i3_containers::node_layout::stacked;
+            on_border = detail::child_border(on_border, vertical_layout, node.is_first_tiling(), node.is_last_tiling(), node.type);
+        }
+
+        if (node.type == node_type::output) {
+            result.output = node.name.value_or("");
+        }
+        else if (node.type == node_type::workspace) {
+            result.workspace = node.id;
+            result.workspace_num = detail::workspace_num(node.name);
+        }
+
+        if (node.is_focused) {
+            result.focused = node.id;
+            result.fullscreen_mode = node.fullscreen_mode;
+            result.position = on_border;
+            return result;
+        }
+    }
+    return tl::nullopt;
+}
+
+/**
+ * Follows the focus from the root down to the focused container
+ *
+ * If the context does not hold a whole tree yet, only the focus path is decoded.
+ * \param ctx The current context
+ * \returns The focus path, or an empty optional if the focused container was not found
+ * */
+[[nodiscard]] inline
+auto analyze_focus(context const & ctx)
+    -> tl::optional<focus_path>
+{
+    if (ctx.has_tree()) {
+        return analyze_focus(ctx.tree());
+    }
+    return analyze_focus(ctx.focus_chain());
+}
+
+/**
+ * Search for the focused container, decoding only the focus path if the context does not hold a
+ * whole tree yet
+ *
+ * \param ctx The current context
+ * \returns An optional with the focused container, or an empty optional if it was not found
+ * */
+[[nodiscard]] inline
+auto focused_container(context const & ctx)
+    -> tl::optional<chain_node>
+{
+    auto const & chain = ctx.focus_chain();
+    if (chain.empty() or not chain.back().is_focused) {
+        return tl::nullopt;
+    }
+    return chain.back();
+}
+
+} // namespace brun
+
+#endif /* FOCUS_PATH_HPP */
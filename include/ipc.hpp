@@ -0,0 +1,441 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : ipc
+ * @created     : Friday Oct 16, 2026 18:22:49 CEST
+ * @description : Raw connection to i3, speaking the IPC wire protocol directly
+ * */
+
+#ifndef IPC_HPP
+#define IPC_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "detail/json.hpp"
+#include "detail/unique_fd.hpp"
+#include "trace.hpp"
+
+// Each message, in both directions, is made of the magic string "i3-ipc", the length of the
+//  payload and the type of the message (both as native-endian uint32), followed by the payload.
+//  Events have the highest bit of the type set.
+namespace brun::ipc
+{
+enum class message_type : std::uint32_t
+{
+    run_command    = 0,
+    get_workspaces = 1,
+    subscribe      = 2,
+    get_outputs    = 3,
+    get_tree       = 4,
+    get_marks      = 5,
+    get_bar_config = 6,
+    get_version    = 7,
+    send_tick      = 10,
+    sync           = 11,
+};
+
+enum class event_type : std::uint32_t
+{
+    workspace = 0,
+    output    = 1,
+    mode      = 2,
+    window    = 3,
+    barconfig = 4,
+    binding   = 5,
+    shutdown  = 6,
+    tick      = 7,
+};
+
+[[nodiscard]] constexpr
+auto name(message_type type) noexcept
+    -> std::string_view
+{
+    switch (type) {
+    case message_type::run_command:    return "run_command";
+    case message_type::get_workspaces: return "get_workspaces";
+    case message_type::subscribe:      return "subscribe";
+    case message_type::get_outputs:    return "get_outputs";
+    case message_type::get_tree:       return "get_tree";
+    case message_type::get_marks:      return "get_marks";
+    case message_type::get_bar_config: return "get_bar_config";
+    case message_type::get_version:    return "get_version";
+    case message_type::send_tick:      return "send_tick";
+    case message_type::sync:           return "sync";
+    }
+    return "unknown";
+}
+
+inline constexpr auto magic = std::string_view{"i3-ipc"};
+inline constexpr auto header_size = magic.size() + 2 * sizeof(std::uint32_t);
+inline constexpr auto event_bit = std::uint32_t{1} << 31;
+
+/**
+ * Thrown when i3 sends something that does not respect the protocol
+ * */
+class bad_message : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct message
+{
+    std::uint32_t type;
+    std::string payload;
+
+    [[nodiscard]] bool is_event() const noexcept { return (type & event_bit) != 0; }
+    [[nodiscard]] auto event() const noexcept { return static_cast<event_type>(type & ~event_bit); }
+};
+
+/**
+ * Returns the path of the i3 socket: `I3SOCK` if set, otherwise the one reported by i3 itself
+ * */
+[[nodiscard]] inline
+auto socket_path()
+    -> std::string
+{
+    if (auto const * path = std::getenv("I3SOCK"); path != nullptr) {
+        return path;
+    }
+    auto path = std::string{};
+    if (auto * pipe = ::popen("i3 --get-socketpath", "r"); pipe != nullptr) {
+        auto buffer = std::array<char, 256>{};
+        while (std::fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
+            path += buffer.data();
+        }
+        ::pclose(pipe);
+    }
+    while (not path.empty() and path.back() == '\n') {
+        path.pop_back();
+    }
+    return path;
+}
+
+namespace detail
+{
+[[nodiscard]] inline
+auto encode_header(std::uint32_t type, std::size_t size)
+    -> std::array<char, header_size>
+{
+    auto const length = static_cast<std::uint32_t>(size);
+    auto header = std::array<char, header_size>{};
+    std::memcpy(header.data(), magic.data(), magic.size());
+    std::memcpy(header.data() + magic.size(), &length, sizeof(length));
+    std::memcpy(header.data() + magic.size() + sizeof(length), &type, sizeof(type));
+    return header;
+}
+
+/**
+ * Decodes a header
+ *
+ * \returns The length of the payload and the type of the message
+ * */
+[[nodiscard]] inline
+auto decode_header(std::array<char, header_size> const & header)
+    -> std::pair<std::uint32_t, std::uint32_t>
+{
+    if (std::string_view{header.data(), magic.size()} != magic) {
+        throw bad_message{"invalid magic string"};
+    }
+    auto length = std::uint32_t{};
+    auto type = std::uint32_t{};
+    std::memcpy(&length, header.data() + magic.size(), sizeof(length));
+    std::memcpy(&type, header.data() + magic.size() + sizeof(length), sizeof(type));
+    return {length, type};
+}
+
+inline
+void write_all(int fd, std::string_view header, std::string_view payload)
+{
+    auto iov = std::array{
+        iovec{const_cast<char *>(header.data()), header.size()},
+        iovec{const_cast<char *>(payload.data()), payload.size()},
+    };
+    auto remaining = header.size() + payload.size();
+    auto * current = iov.data();
+    auto count = 2;
+    while (remaining > 0) {
+        auto const written = ::writev(fd, current, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error{errno, std::generic_category(), "write to i3 socket"};
+        }
+        remaining -= static_cast<std::size_t>(written);
+        for (auto left = static_cast<std::size_t>(written); left > 0 and count > 0; ) {
+            auto const step = std::min(left, current->iov_len);
+            current->iov_base = static_cast<char *>(current->iov_base) + step;
+            current->iov_len -= step;
+            left -= step;
+            if (current->iov_len == 0) {
+                ++current;
+                --count;
+            }
+        }
+    }
+}
+
+inline
+void read_all(int fd, char * buffer, std::size_t size)
+{
+    while (size > 0) {
+        auto const received = ::read(fd, buffer, size);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error{errno, std::generic_category(), "read from i3 socket"};
+        }
+        if (received == 0) {
+            throw bad_message{"connection closed by i3"};
+        }
+        buffer += received;
+        size -= static_cast<std::size_t>(received);
+    }
+}
+} // namespace detail
+
+
+/**
+ * A connection to i3 which sends and receives raw messages.
+ *
+ * Replies are returned as the JSON text sent by i3, so that the caller can decode only what it
+ * needs. A connection used to `subscribe` also receives the events, interleaved with the replies.
+ * */
+class connection
+{
+private:
+    brun::detail::unique_fd _socket;
+    message _reply{};   // reused by `request_view`
+
+    /// Sends a message and receives its reply into `reply`
+    void exchange(message_type type, std::string_view payload, message & reply)
+    {
+        auto span = trace::span{name(type), "ipc"};
+        span.arg("payload_bytes", payload.size());
+        send(type, payload);
+        receive(reply);
+        span.arg("reply_bytes", reply.payload.size());
+        if (reply.type != static_cast<std::uint32_t>(type)) {
+            throw bad_message{fmt::format("expected a reply of type {}, got {}", static_cast<std::uint32_t>(type), reply.type)};
+        }
+    }
+
+public:
+    explicit connection(std::string const & path = socket_path())
+    {
+        auto const span = trace::span{"connect", "ipc"};
+        auto address = sockaddr_un{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() or path.size() >= sizeof(address.sun_path)) {
+            throw std::system_error{ENAMETOOLONG, std::generic_category(), "i3 socket path"};
+        }
+        std::memcpy(address.sun_path, path.data(), path.size());
+        _socket.reset(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (not _socket
+                or ::connect(_socket.get(), reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0) {
+            throw std::system_error{errno, std::generic_category(), fmt::format("connect to {}", path)};
+        }
+    }
+
+    /// The file descriptor of the socket, e.g. to wait for events with poll
+    [[nodiscard]] int fd() const noexcept { return _socket.get(); }
+
+    /// Whether a message has already arrived, so that `receive` would not block
+    [[nodiscard]]
+    bool has_message() const
+    {
+        auto fd = pollfd{_socket.get(), POLLIN, 0};
+        while (::poll(&fd, 1, 0) < 0) {
+            if (errno != EINTR) {
+                throw std::system_error{errno, std::generic_category(), "poll on i3 socket"};
+            }
+        }
+        return (fd.revents & POLLIN) != 0;
+    }
+
+    void send(message_type type, std::string_view payload = {})
+    {
+        auto const header = detail::encode_header(static_cast<std::uint32_t>(type), payload.size());
+        detail::write_all(_socket.get(), {header.data(), header.size()}, payload);
+    }
+
+    /**
+     * Receives the next message, either a reply or an event, into `into`
+     *
+     * The payload reuses the memory of the previous one, so that a loop receiving into the same
+     * message does not allocate once the largest message has been seen.
+     * */
+    void receive(message & into)
+    {
+        auto header = std::array<char, header_size>{};
+        detail::read_all(_socket.get(), header.data(), header.size());
+        auto const [length, type] = detail::decode_header(header);
+        into.type = type;
+        into.payload.resize(length);
+        detail::read_all(_socket.get(), into.payload.data(), length);
+    }
+
+    /**
+     * Receives the next message, either a reply or an event
+     * */
+    [[nodiscard]]
+    auto receive()
+        -> message
+    {
+        auto result = message{};
+        receive(result);
+        return result;
+    }
+
+    /**
+     * Sends a message and waits for its reply
+     *
+     * Must not be used on a subscribed connection, where an event could come before the reply.
+     * \returns The payload of the reply
+     * */
+    [[nodiscard]]
+    auto request(message_type type, std::string_view payload = {})
+        -> std::string
+    {
+        auto reply = message{};
+        exchange(type, payload, reply);
+        return std::move(reply.payload);
+    }
+
+    /**
+     * Sends a message and waits for its reply, received in a buffer of the connection
+     *
+     * Meant for the replies that are decoded right away: the buffer is reused by every request,
+     * so that asking again for a tree does not allocate another one.
+     * 
+     * \returns The payload of the reply, valid until the next call of `request_view`
+     * */
+    [[nodiscard]]
+    auto request_view(message_type type, std::string_view payload = {})
+        -> std::string_view
+    {
+        exchange(type, payload, _reply);
+        return _reply.payload;
+    }
+
+    /**
+     * Sends all the requests at once and then reads their replies, which i3 sends in the same order.
+     *
+     * The requests are written with a single write, so that fetching several replies costs a
+     * single round trip instead of one for each of them. Like `request`, it must not be used on a
+     * subscribed connection.
+     * \param types The requests, all without a payload (e.g. `get_tree`, `get_workspaces`)
+     * \returns The payloads of the replies, in the order of the requests
+     * */
+    [[nodiscard]]
+    auto request_all(std::span<message_type const> types)
+        -> std::vector<std::string>
+    {
+        auto span = trace::span{"pipeline", "ipc"};
+        span.arg("requests", types.size());
+        auto headers = std::string{};
+        headers.reserve(types.size() * header_size);
+        for (auto const type : types) {
+            auto const header = detail::encode_header(static_cast<std::uint32_t>(type), 0);
+            headers.append(header.data(), header.size());
+        }
+        detail::write_all(_socket.get(), headers, {});
+
+        auto replies = std::vector<std::string>{};
+        replies.reserve(types.size());
+        auto reply = message{};
+        for (auto const type : types) {
+            receive(reply);
+            if (reply.type != static_cast<std::uint32_t>(type)) {
+                throw bad_message{fmt::format("expected a reply of type {}, got {}", static_cast<std::uint32_t>(type), reply.type)};
+            }
+            replies.push_back(std::exchange(reply.payload, {}));
+        }
+        return replies;
+    }
+
+    /**
+     * Pipelines a fixed set of requests, e.g. `auto [tree, workspaces] = i3.request_all(get_tree, get_workspaces);`
+     *
+     * \returns The payloads of the replies, in the order of the requests
+     * */
+    template <std::same_as<message_type>... Types>
+    [[nodiscard]]
+    auto request_all(Types... types)
+        -> std::array<std::string, sizeof...(Types)>
+    {
+        auto const list = std::array{types...};
+        auto replies = request_all(std::span<message_type const>{list});
+        return [&replies]<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array{std::move(replies[I])...};
+        }(std::make_index_sequence<sizeof...(Types)>{});
+    }
+
+    /**
+     * Subscribes to the events listed in `events`, a JSON array (e.g. `["output","workspace"]`)
+     *
+     * Must be called once, before the connection can receive any event; from then on the events
+     * are read with `receive`.
+     * */
+    void subscribe(std::string_view events)
+    {
+        auto const reply = request(message_type::subscribe, events);
+        auto json = json::reader{reply};
+        json.begin_object();
+        while (auto const key = json.next_key()) {
+            if (*key == "success") {
+                if (not json.read_bool()) {
+                    throw bad_message{fmt::format("subscription to {} refused", events)};
+                }
+                return;
+            }
+            json.skip_value();
+        }
+        throw bad_message{"subscription reply without success"};
+    }
+};
+
+/**
+ * Reads the `change` of an event (e.g. "focus" for a workspace event)
+ *
+ * \returns The change, or an empty string if the event has none
+ * */
+[[nodiscard]] inline
+auto event_change(std::string_view payload)
+    -> std::string
+{
+    auto json = json::reader{payload};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "change") {
+            return json.read_string();
+        }
+        json.skip_value();
+    }
+    return {};
+}
+} // namespace brun::ipc
+
+#endif /* IPC_HPP */
@@ -0,0 +1,259 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : lazy_tree
+ * @created     : Friday Oct 16, 2026 21:31:02 CEST
+ * @description : Decoder of GET_TREE which only materializes the focused containers
+ * */
+
+#ifndef LAZY_TREE_HPP
+#define LAZY_TREE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "detail/i3_json.hpp"
+#include "detail/json.hpp"
+#include "trace.hpp"
+
+namespace brun
+{
+
+/**
+ * A container on the focus path, with its position among its siblings
+ * */
+struct chain_node
+{
+    uint64_t id = 0;
+    tl::optional<std::string> name;
+    i3_containers::node_type type = i3_containers::node_type::root;
+    i3_containers::node_layout layout = i3_containers::node_layout::splith;
+    decltype(i3_containers::node::rect) rect{};
+    bool is_focused = false;
+    i3_containers::fullscreen_mode_type fullscreen_mode = i3_containers::fullscreen_mode_type::no_fullscreen;
+    std::vector<std::string> marks;
+
+    // Position in the parent: the index among the tiling (or floating) children, and the number
+    //  of tiling children of the parent
+    std::uint32_t sibling_index = 0;
+    std::uint32_t tiling_siblings = 1;
+    bool is_floating = false;
+
+    [[nodiscard]] bool is_first_tiling() const noexcept { return not is_floating and sibling_index == 0; }
+    [[nodiscard]] bool is_last_tiling()  const noexcept { return not is_floating and sibling_index + 1 == tiling_siblings; }
+};
+
+namespace detail
+{
+/// An object or an array open at some point of the scan
+struct scan_level
+{
+    std::size_t offset;             // of the opening brace or bracket
+    bool is_array = false;
+    std::uint8_t kind = 0;          // for the arrays: 1 for `nodes`, 2 for `floating_nodes`
+    std::uint32_t count = 0;        // for the arrays: the objects seen so far
+    std::uint32_t index = 0;        // for the objects: the position in the parent array
+    std::array<std::size_t, 2> children_end = {0, 0};  // for the objects: end of `nodes` and `floating_nodes`
+    bool open = true;
+};
+
+/// Returns the position of the quote closing the string which starts at `pos`
+[[nodiscard]] inline
+auto string_end(std::string_view text, std::size_t pos)
+    -> std::size_t
+{
+    while (true) {
+        pos = text.find('"', pos + 1);
+        if (pos == std::string_view::npos) {
+            throw json::parse_error{"unterminated string", text.size()};
+        }
+        auto backslashes = std::size_t{0};
+        while (text[pos - 1 - backslashes] == '\\') {
+            ++backslashes;
+        }
+        if (backslashes % 2 == 0) {
+            return pos;
+        }
+    }
+}
+
+/// Check if the text at `pos` is `: true`
+[[nodiscard]] inline
+bool is_true_value(std::string_view text, std::size_t pos)
+{
+    auto const value = text.find_first_not_of(" \t\r\n", pos);
+    if (value == std::string_view::npos or text[value] != ':') {
+        return false;
+    }
+    auto const literal = text.find_first_not_of(" \t\r\n", value + 1);
+    return literal != std::string_view::npos and text.substr(literal, 4) == "true";
+}
+
+/**
+ * Scans the whole text once, looking only at the structure, and returns the objects and the
+ * arrays enclosing the focused container (the one with `"focused": true`) in their final state.
+ * */
+[[nodiscard]] inline
+auto scan_focus_path(std::string_view text)
+    -> std::vector<scan_level>
+{
+    auto stack = std::vector<scan_level>{};
+    auto path = std::vector<scan_level>{};
+    auto found = false;
+    auto last_key = std::string_view{};
+    stack.reserve(64);
+
+    for (auto pos = std::size_t{0}; pos < text.size(); ++pos) {
+        switch (text[pos]) {
+        case '"': {
+            auto const end = string_end(text, pos);
+            last_key = text.substr(pos + 1, end - pos - 1);
+            if (not found and last_key == "focused" and not stack.empty() and not stack.back().is_array
+                    and is_true_value(text, end + 1)) {
+                found = true;
+                path = stack;
+            }
+            pos = end;
+            break;
+        }
+        case '{': {
+            auto level = scan_level{pos};
+            if (not stack.empty() and stack.back().is_array) {
+                level.index = stack.back().count++;
+            }
+            stack.push_back(level);
+            break;
+        }
+        case '[': {
+            auto level = scan_level{pos, true};
+            level.kind = last_key == "nodes" ? 1 : last_key == "floating_nodes" ? 2 : 0;
+            stack.push_back(level);
+            break;
+        }
+        case '}':
+        case ']': {
+            if (stack.empty()) {
+                throw json::parse_error{"unbalanced brackets", pos};
+            }
+            auto const depth = stack.size() - 1;
+            auto const level = stack.back();
+            stack.pop_back();
+            if (level.is_array and level.kind != 0 and not stack.empty()) {
+                stack.back().children_end[level.kind - 1u] = pos + 1;
+            }
+            // the first level closed at a depth of the path is the one of the path
+            if (found and depth < path.size() and path[depth].open) {
+                path[depth] = level;
+                path[depth].open = false;
+            }
+            if (stack.empty()) {
+                return path;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    throw json::parse_error{"unterminated value", text.size()};
+}
+
+/// Decodes the fields of a container, jumping over its children
+inline
+void decode_chain_node(json::reader & json, scan_level const & level, chain_node & node)
+{
+    json.seek(level.offset);
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "id") {
+            node.id = json.read_number<uint64_t>();
+        }
+        else if (*key == "type") {
+            node.type = json::read_node_type(json);
+        }
+        else if (*key == "layout") {
+            node.layout = json::read_node_layout(json);
+        }
+        else if (*key == "rect") {
+            json::read_rect(json, node.rect);
+        }
+        else if (*key == "name") {
+            if (not json.read_null()) {
+                node.name = json.read_string();
+            }
+        }
+        else if (*key == "focused") {
+            node.is_focused = json.read_bool();
+        }
+        else if (*key == "fullscreen_mode") {
+            node.fullscreen_mode = json::read_fullscreen_mode(json);
+        }
+        else if (*key == "marks") {
+            json.begin_array();
+            while (json.next_element()) {
+                node.marks.push_back(json.read_string());
+            }
+        }
+        else if (*key == "nodes" and level.children_end[0] != 0) {
+            json.seek(level.children_end[0]);
+        }
+        else if (*key == "floating_nodes" and level.children_end[1] != 0) {
+            json.seek(level.children_end[1]);
+        }
+        else {
+            json.skip_value();
+        }
+    }
+}
+} // namespace detail
+
+
+/**
+ * Decodes the reply to GET_TREE materializing only the containers from the root to the focused
+ * one, without allocating anything for the others.
+ *
+ * Since i3 writes the `focus` list of a container after its children, following it would mean
+ * walking each subtree on the path again. Instead, the text is scanned once looking only at its
+ * structure (braces, brackets and strings), which finds the containers enclosing the focused one
+ * together with their position among the siblings and the end of their lists of children; then
+ * only those containers are decoded, jumping over their children.
+ * \param tree The JSON text of the tree
+ * \returns The containers from the root (first) to the focused one (last), or only the root if
+ *          no container is focused
+ * */
+[[nodiscard]] inline
+auto decode_focus_chain(std::string_view tree)
+    -> std::vector<chain_node>
+{
+    auto span = trace::span{"decode_focus_chain", "parse"};
+    span.arg("bytes", tree.size());
+    auto path = detail::scan_focus_path(tree);
+    auto json = json::reader{tree};
+    auto chain = std::vector<chain_node>{};
+    if (path.empty()) {
+        path.push_back(detail::scan_level{json.position()});
+        json.skip_whitespace();
+        path.back().offset = json.position();
+    }
+
+    // The path alternates the objects of the containers and the arrays of their children
+    for (auto i = std::size_t{0}; i < path.size(); i += 2) {
+        auto & node = chain.emplace_back();
+        if (i != 0) {
+            auto const & siblings = path[i - 1];
+            node.sibling_index = path[i].index;
+            node.is_floating = siblings.kind == 2;
+            node.tiling_siblings = siblings.kind == 1 ? siblings.count : 0;
+        }
+        detail::decode_chain_node(json, path[i], node);
+    }
+    return chain;
+}
+
+} // namespace brun
+
+#endif /* LAZY_TREE_HPP */
@@ -0,0 +1,263 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : marks
+ * @created     : Friday Oct 16, 2026 20:12:09 CEST
+ * @description : Index of the marks, with the workspace and the output of each marked container
+ * */
+
+#ifndef MARKS_HPP
+#define MARKS_HPP
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "trace.hpp"
+#include "tree_range.hpp"
+#include "utils.hpp"
+
+namespace brun
+{
+
+/**
+ * Where a marked container lives
+ * */
+struct mark_location
+{
+    uint64_t container;
+    uint64_t workspace;              // id of the workspace containing the container
+    tl::optional<int> workspace_num;
+    std::string output;
+};
+
+namespace detail
+{
+/// The number i3 gives to a workspace: the one its name starts with, if any
+[[nodiscard]] inline
+auto workspace_num(auto const & name)
+    -> tl::optional<int>
+{
+    return name.has_value() ? brun::stoi(*name) : tl::nullopt;
+}
+
+/// Check if the container or any of its descendants has a mark
+[[nodiscard]] inline
+bool holds_marks(i3_containers::node const & node)
+{
+    return std::ranges::any_of(preorder(node), [](auto const & n) { return not n.marks.empty(); });
+}
+
+/// Workspace and output under which the containers are found, while visiting the tree
+struct mark_visit
+{
+    i3_containers::node const * workspace = nullptr;
+    i3_containers::node const * output = nullptr;
+
+    [[nodiscard]]
+    auto enter(i3_containers::node const & node) const
+        -> mark_visit
+    {
+        using i3_containers::node_type;
+        auto result = *this;
+        if (node.type == node_type::output) {
+            result.output = &node;
+        }
+        else if (node.type == node_type::workspace) {
+            result.workspace = &node;
+        }
+        return result;
+    }
+
+    /// The workspace and the output of the last container of `path`, which starts from the root
+    [[nodiscard]]
+    static auto along(auto const & path)
+        -> mark_visit
+    {
+        auto visit = mark_visit{};
+        for (auto const & node : path) {
+            visit = visit.enter(node);
+        }
+        return visit;
+    }
+
+    [[nodiscard]]
+    auto locate(uint64_t container) const
+        -> mark_location
+    {
+        return {
+            container,
+            workspace != nullptr ? workspace->id : 0,
+            workspace != nullptr ? workspace_num(workspace->name) : tl::nullopt,
+            output != nullptr ? output->name.value_or("") : "",
+        };
+    }
+};
+} // namespace detail
+
+
+/**
+ * Maps each mark to the container that holds it, together with the workspace and the output of
+ * the container, so that resolving a mark is a single hash lookup.
+ *
+ * The index is built with one visit of the tree and can then be kept up to date with the
+ * `mark`, `close` and workspace `rename`/`empty` events; the events that move containers around
+ * are not applied, and the index must be built again after them.
+ * */
+class mark_index
+{
+private:
+    std::unordered_map<std::string, mark_location> _marks;
+
+    void index(i3_containers::node const & root)
+    {
+        for (auto it = preorder(root).begin(); it != std::default_sentinel; ++it) {
+            if (it->marks.empty()) {
+                continue;
+            }
+            auto const location = detail::mark_visit::along(it.path()).locate(it->id);
+            for (auto const & mark : it->marks) {
+                _marks.insert_or_assign(mark, location);
+            }
+        }
+    }
+
+    /// Searches a container in the tree, returning its location
+    static
+    auto locate(i3_containers::node const & root, uint64_t id)
+        -> tl::optional<mark_location>
+    {
+        for (auto it = preorder(root).begin(); it != std::default_sentinel; ++it) {
+            if (it->id == id) {
+                return detail::mark_visit::along(it.path()).locate(id);
+            }
+        }
+        return tl::nullopt;
+    }
+
+public:
+    mark_index() = default;
+
+    /**
+     * Builds the index with a single visit of the tree
+     * */
+    explicit mark_index(i3_containers::node const & root)
+    {
+        auto span = trace::span{"build_mark_index", "tree"};
+        index(root);
+        span.arg("marks", _marks.size());
+    }
+
+    [[nodiscard]] auto size() const noexcept { return _marks.size(); }
+
+    /// \name The marks, each one with the location of its container
+    /// \{
+    [[nodiscard]] auto begin() const noexcept { return _marks.begin(); }
+    [[nodiscard]] auto end() const noexcept { return _marks.end(); }
+    /// \}
+
+    /**
+     * Adds a mark, e.g. read from an index built by another process
+     * */
+    void insert(std::string mark, mark_location location)
+    {
+        _marks.insert_or_assign(std::move(mark), std::move(location));
+    }
+
+    /**
+     * Removes the marks of a container, e.g. one closed by i3 without an event of its own
+     * */
+    void erase_container(uint64_t id)
+    {
+        std::erase_if(_marks, [id](auto const & entry) { return entry.second.container == id; });
+    }
+
+    /**
+     * Search a mark, in constant time
+     * */
+    [[nodiscard]]
+    auto find(std::string_view mark) const
+        -> tl::optional<mark_location>
+    {
+        auto const found = _marks.find(std::string{mark});
+        if (found == _marks.end()) {
+            return tl::nullopt;
+        }
+        return found->second;
+    }
+
+    /**
+     * Applies a window event
+     *
+     * \param event The event
+     * \param root The tree, already updated with the event
+     * \returns `false` if the event cannot be applied, and the index must be built again
+     * */
+    bool apply(i3_containers::window_event const & event, i3_containers::node const & root)
+    {
+        using i3_containers::window_change;
+        auto const & container = event.container;
+        switch (event.change) {
+        case window_change::mark: {
+            erase_container(container.id);
+            if (container.marks.empty()) {
+                return true;
+            }
+            auto const location = locate(root, container.id);
+            if (not location.has_value()) {
+                return false;
+            }
+            for (auto const & mark : container.marks) {
+                _marks.insert_or_assign(mark, *location);
+            }
+            return true;
+        }
+        case window_change::close:
+            erase_container(container.id);
+            return true;
+        case window_change::move:
+        case window_change::floating:
+            // the event carries the whole moved subtree: only the marks in it are affected
+            return not detail::holds_marks(container);
+        default:
+            return true;
+        }
+    }
+
+    /**
+     * Applies a workspace event
+     *
+     * \returns `false` if the event cannot be applied, and the index must be built again
+     * */
+    bool apply(i3_containers::workspace_event const & event)
+    {
+        using i3_containers::workspace_change;
+        if (not event.current.has_value()) {
+            return false;
+        }
+        auto const & workspace = *event.current;
+        switch (event.change) {
+        case workspace_change::rename:
+            for (auto & [mark, location] : _marks) {
+                if (location.workspace == workspace.id) {
+                    location.workspace_num = detail::workspace_num(workspace.name);
+                }
+            }
+            return true;
+        case workspace_change::empty:
+            erase_container(workspace.id);
+            return true;
+        case workspace_change::move:
+            return std::ranges::none_of(_marks, [&](auto const & entry) { return entry.second.workspace == workspace.id; });
+        default:
+            return true;
+        }
+    }
+};
+
+} // namespace brun
+
+#endif /* MARKS_HPP */
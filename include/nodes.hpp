@@ -12,6 +12,10 @@
 #include <i3-ipc++/i3_ipc.hpp>
 #include <tl/optional.hpp>
 
+#include "context.hpp"
+#include "snapshot.hpp"
+#include "tree_range.hpp"
+
 #ifdef ENABLE_DEBUG
 #include <fmt/core.h>
 #endif
@@ -23,32 +27,66 @@ namespace detail
 {
 [[nodiscard]] inline
 auto focused_node_impl(i3_containers::node const & node)
-    -> tl::optional<i3_containers::node>
+    -> tl::optional<i3_containers::node const &>
 {
-    if (node.is_focused) {
-        return node;
+    auto chain = focus_chain(node);
+    auto const focused = std::ranges::find_if(chain, &i3_containers::node::is_focused);
+    if (focused == chain.end()) {
+        return tl::nullopt;
     }
-
-    auto const id_of_focused_child = node.focus.front();
-    auto const focused_child = std::ranges::find(node.nodes, id_of_focused_child, &i3_containers::node::id);
-    if (focused_child != std::ranges::end(node.nodes)) {
-        return focused_node_impl(*focused_child);
+    return *focused;
+}
+/// \exclude
+[[nodiscard]] inline
+auto focused_node_impl(snapshot::node_ref node)
+    -> tl::optional<snapshot::node_ref>
+{
+    while (not node.is_focused()) {
+        auto const focused_child = node.focused_child();
+        if (not focused_child.has_value()) {
+            return tl::nullopt;
+        }
+        node = *focused_child;
     }
-    return tl::nullopt;
+    return node;
 }
 } // namespace detail
 
 
+/**
+ * Search the snapshot for the focused node
+ *
+ * \param tree The snapshot of the tree
+ * \returns An optional with the focused node, or an empty optional if it was not found
+ */
+[[nodiscard]] inline
+auto focused_node(snapshot const & tree)
+{
+    return detail::focused_node_impl(tree.root());
+}
+
+/**
+ * Search the tree for the focused node
+ *
+ * \param root The root of the tree
+ * \returns An optional with the focused node, or an empty optional if it was not found
+ */
+[[nodiscard]] inline
+auto focused_node(i3_containers::node const & root)
+{
+    return detail::focused_node_impl(root);
+}
+
 /**
  * Search the tree for the focused node
  *
- * \param i3 The i3 instance
+ * \param ctx The current context
  * \returns An optional with the focused node, or an empty optional if it was not found
  */
 [[nodiscard]] inline
-auto focused_node(i3_ipc const & i3)
+auto focused_node(context const & ctx)
 {
-    return detail::focused_node_impl(i3.get_tree());
+    return focused_node(ctx.flat_tree());
 }
 
 
@@ -150,97 +188,159 @@ auto print_border(border x)
 
 namespace detail
 {
+/**
+ * Computes the border on which the focused child of a container is
+ *
+ * \param on_border The border on which the container is
+ * \param vertical_layout If the children of the container are stacked vertically
+ * \param is_first If the child is the first tiling child of the container
+ * \param is_last If the child is the last tiling child of the container
+ * \param child_type The type of the child
+ * */
+[[nodiscard]] constexpr
+auto child_border(border on_border, bool vertical_layout, bool is_first, bool is_last, i3_containers::node_type child_type)
+    -> border
+{
+    if (child_type != i3_containers::node_type::con) {
+        return border::unique;
+    }
+    if (on_border == border::no) {
+        return border::no;
+    }
+    auto const on_left  = is_on_<border::left>(on_border)   and (vertical_layout or is_first);
+    auto const on_right = is_on_<border::right>(on_border)  and (vertical_layout or is_last);
+    auto const on_top   = is_on_<border::top>(on_border)    and (not vertical_layout or is_first);
+    auto const on_bot   = is_on_<border::bottom>(on_border) and (not vertical_layout or is_last);
+    return (on_left  ? border::left   : border::no)
+         | (on_right ? border::right  : border::no)
+         | (on_top   ? border::top    : border::no)
+         | (on_bot   ? border::bottom : border::no)
+         ;
+}
+
 /// \exclude
 [[nodiscard]] inline
-auto node_on_border_impl(i3_containers::node const & node, border on_border)
+auto node_on_border_impl(i3_containers::node const & root, border on_border)
     -> border
 {
-    if (node.is_focused) {
-        return border::unique;
+    auto const * parent = static_cast<i3_containers::node const *>(nullptr);
+    for (auto const & node : focus_chain(root)) {
+        if (parent != nullptr) {
+            auto const vertical_layout = parent->layout == i3_containers::node_layout::splitv
+                                      or parent->layout == i3_containers::node_layout::stacked;
+            auto const & tiling = parent->nodes;
+            auto const is_first = not tiling.empty() and &node == &tiling.front();
+            auto const is_last  = not tiling.empty() and &node == &tiling.back();
+            on_border = child_border(on_border, vertical_layout, is_first, is_last, node.type);
+        }
+        if (node.is_focused) {
+#ifdef ENABLE_DEBUG
+            fmt::print("The focused container is on border: {}\n", print_border(on_border));
+#endif
+            return parent != nullptr ? on_border : border::unique;
+        }
+        parent = &node;
     }
+    return border::unique;
+}
 
-    if (node.focus.empty()) {
+/// \exclude
+[[nodiscard]] inline
+auto node_on_border_impl(snapshot::node_ref node, border on_border)
+    -> border
+{
+    if (node.is_focused()) {
         return border::unique;
     }
 
-    auto const vertical_layout = node.layout == i3_containers::node_layout::splitv
-                              or node.layout == i3_containers::node_layout::stacked;
-
-    auto const id_of_focused_child = node.focus.front();
-    auto const focused_child = std::ranges::find(node.nodes, id_of_focused_child, &i3_containers::node::id);
-
-    auto const child_on_left  = is_on_<border::left>(on_border)
-                            and (vertical_layout or focused_child->id == node.nodes.front().id);
-    auto const child_on_right = is_on_<border::right>(on_border)
-                            and (vertical_layout or focused_child->id == node.nodes.back().id);
-    auto const child_on_top   = is_on_<border::top>(on_border)
-                            and (not vertical_layout or focused_child->id == node.nodes.front().id);
-    auto const child_on_bot   = is_on_<border::bottom>(on_border)
-                            and (not vertical_layout or focused_child->id == node.nodes.back().id);
-    auto const child_position = [=] {
-        if (focused_child->type != i3_containers::node_type::con) {
+    while (true) {
+        auto const focused_child = node.focused_child();
+        if (not focused_child.has_value()) {
             return border::unique;
         }
-        if (on_border == border::no) {
-            return border::no;
-        }
-        return (child_on_left  ? border::left   : border::no)
-             | (child_on_right ? border::right  : border::no)
-             | (child_on_top   ? border::top    : border::no)
-             | (child_on_bot   ? border::bottom : border::no)
-             ;
-    }();
-    if (focused_child->is_focused) {
+
+        auto const vertical_layout = node.layout() == i3_containers::node_layout::splitv
+                                  or node.layout() == i3_containers::node_layout::stacked;
+
+        auto const is_child = [&focused_child](auto child) { return child == *focused_child; };
+        auto const is_first = node.first_tiling_child().map(is_child).value_or(false);
+        auto const is_last  = node.last_tiling_child().map(is_child).value_or(false);
+
+        auto const child_position = child_border(on_border, vertical_layout, is_first, is_last, focused_child->type());
+        if (focused_child->is_focused()) {
 #ifdef ENABLE_DEBUG
-        fmt::print("Of {} childs, one is focused:\n", node.nodes.size());
-        fmt::print("This container is on border: {}\n", print_border(on_border));
-        fmt::print("This container has vertical layout: {}\n", vertical_layout);
-        fmt::print("Child is on left: {}\n", child_on_left);
-        fmt::print("Child is on right: {}\n", child_on_right);
-        fmt::print("Child is on top: {}\n", child_on_top);
-        fmt::print("Child is on bottom: {}\n", child_on_bot);
+            fmt::print("Of {} childs, one is focused:\n", node.child_count());
+            fmt::print("This container is on border: {}\n", print_border(on_border));
+            fmt::print("This container has vertical layout: {}\n", vertical_layout);
 #endif
-        return child_position;
+            return child_position;
+        }
+        node = *focused_child;
+        on_border = child_position;
     }
-    return node_on_border_impl(*focused_child, child_position);
 }
 } // namespace detail
 
 /**
  * Retrieves the border in which the focused node is located
  *
- * \param node The root of the tree where you are searching for the focused node
+ * \param tree The snapshot of the tree
+ * \returns The `border` representing the position of the focused node
+ * */
+[[nodiscard]] inline
+auto node_on_border(snapshot const & tree)
+{
+    return detail::node_on_border_impl(tree.root(), border::unique);
+}
+
+/**
+ * Retrieves the border in which the focused node is located
+ *
+ * \param root The root of the tree where you are searching for the focused node
  * \returns The `border` representing the position of the focused node
  * */
 [[nodiscard]] inline
-auto node_on_border(i3_ipc const & i3)
+auto node_on_border(i3_containers::node const & root)
 {
-    return detail::node_on_border_impl(i3.get_tree(), border::unique);
+    return detail::node_on_border_impl(root, border::unique);
 }
 
+/**
+ * Retrieves the border in which the focused node is located
+ *
+ * \param ctx The current context
+ * \returns The `border` representing the position of the focused node
+ * */
 [[nodiscard]] inline
-auto find_node_by_mark(i3_containers::node const & node, std::string_view const mark)
-    -> tl::optional<i3_containers::node>
+auto node_on_border(context const & ctx)
 {
-    if (std::ranges::find(node.marks, mark) != node.marks.end()) {
-        return node;
-    }
+    return node_on_border(ctx.flat_tree());
+}
 
-    for (auto const & child : node.nodes) {
-        auto res = find_node_by_mark(child, mark);
-        if (res.has_value()) {
-            return res;
-        }
+[[nodiscard]] inline
+auto find_node_by_mark(i3_containers::node const & root, std::string_view const mark)
+    -> tl::optional<i3_containers::node const &>
+{
+    auto nodes = preorder(root);
+    auto const found = std::ranges::find_if(nodes, with_mark(mark));
+    if (found == nodes.end()) {
+        return tl::nullopt;
     }
+    return *found;
+}
 
-    return tl::nullopt;
+[[nodiscard]] inline
+auto find_node_by_mark(snapshot const & tree, std::string_view const mark)
+    -> tl::optional<snapshot::node_ref>
+{
+    return tree.find_mark(mark);
 }
 
 [[nodiscard]] inline
-auto find_node_by_mark(i3_ipc const & i3, std::string_view const mark)
-    -> tl::optional<i3_containers::node>
+auto find_node_by_mark(context const & ctx, std::string_view const mark)
+    -> tl::optional<snapshot::node_ref>
 {
-    return find_node_by_mark(i3.get_tree(), mark);
+    return find_node_by_mark(ctx.flat_tree(), mark);
 }
 
 
@@ -0,0 +1,319 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : output_topology
+ * @created     : Saturday Oct 17, 2026 14:26:50 CEST
+ * @description : Arrangement of the outputs in rows and columns, with their neighbors and their workspaces
+ * */
+
+#ifndef OUTPUT_TOPOLOGY_HPP
+#define OUTPUT_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "trace.hpp"
+#include "utils.hpp"
+
+namespace brun
+{
+
+/// A direction on the screen, as in `focus left`
+enum class direction : std::uint8_t { left, right, up, down };
+
+/**
+ * Reads a direction as i3 writes it
+ * */
+[[nodiscard]] inline
+auto parse_direction(std::string_view text)
+    -> tl::optional<direction>
+{
+    if (text == "left")  { return direction::left; }
+    if (text == "right") { return direction::right; }
+    if (text == "up")    { return direction::up; }
+    if (text == "down")  { return direction::down; }
+    return tl::nullopt;
+}
+
+/**
+ * The active outputs, ordered as the workspace numbers are assigned to them.
+ *
+ * The outputs are grouped in rows, from top to bottom, and each row is ordered from left to right:
+ * an output belongs to a row if its vertical center is above the bottom of the row, so that
+ * monitors side by side but not aligned still form a single row. With a single row this is the
+ * order from left to right.
+ * Output `k` (counting from 0) owns the workspaces from `10 * k + 1` to `10 * k + 10`.
+ *
+ * Everything is computed when the topology is built, so that every query is a lookup; the
+ * topology only changes with the outputs, except for the visible workspaces (see `update_visible`).
+ * */
+class output_topology
+{
+public:
+    using index = std::size_t;
+    using rect_type = decltype(i3_containers::output::rect);
+    static constexpr auto per_output = 10;
+
+private:
+    static constexpr auto npos = std::numeric_limits<index>::max();
+
+    std::vector<std::string> _names;
+    std::vector<rect_type> _rect;
+    std::vector<std::uint32_t> _row;
+    std::vector<std::uint32_t> _column;
+    std::vector<std::array<index, 4>> _neighbors;   // by `direction`
+    std::vector<tl::optional<std::string>> _visible;
+    std::unordered_map<std::string, index> _index_of;
+    std::uint32_t _rows = 0;
+
+    /// How much the ranges [a, a + a_size) and [b, b + b_size) overlap
+    [[nodiscard]]
+    static auto overlap(std::int64_t a, std::int64_t a_size, std::int64_t b, std::int64_t b_size) noexcept
+        -> std::int64_t
+    {
+        return std::min(a + a_size, b + b_size) - std::max(a, b);
+    }
+
+    /**
+     * The output next to `from` in direction `dir`: the nearest among the ones beyond its border
+     * that overlap it on the other axis, preferring the largest overlap
+     * */
+    [[nodiscard]]
+    auto find_neighbor(index from, direction dir) const noexcept
+        -> index
+    {
+        auto const & r = _rect[from];
+        auto best = npos;
+        auto best_distance = std::numeric_limits<std::int64_t>::max();
+        auto best_overlap = std::int64_t{0};
+        for (auto idx = index{0}; idx < _rect.size(); ++idx) {
+            auto const & c = _rect[idx];
+            auto distance = std::int64_t{-1};
+            auto shared = std::int64_t{0};
+            switch (dir) {
+            case direction::left:
+                distance = std::int64_t{r.x} - (std::int64_t{c.x} + c.width);
+                shared = overlap(r.y, r.height, c.y, c.height);
+                break;
+            case direction::right:
+                distance = std::int64_t{c.x} - (std::int64_t{r.x} + r.width);
+                shared = overlap(r.y, r.height, c.y, c.height);
+                break;
+            case direction::up:
+                distance = std::int64_t{r.y} - (std::int64_t{c.y} + c.height);
+                shared = overlap(r.x, r.width, c.x, c.width);
+                break;
+            case direction::down:
+                distance = std::int64_t{c.y} - (std::int64_t{r.y} + r.height);
+                shared = overlap(r.x, r.width, c.x, c.width);
+                break;
+            }
+            if (idx == from or distance < 0 or shared <= 0) {
+                continue;
+            }
+            if (distance < best_distance or (distance == best_distance and shared > best_overlap)) {
+                best = idx;
+                best_distance = distance;
+                best_overlap = shared;
+            }
+        }
+        return best;
+    }
+
+public:
+    output_topology() = default;
+
+    /**
+     * Builds the topology from the reply to GET_OUTPUTS, ignoring the inactive outputs
+     * */
+    explicit output_topology(std::span<i3_containers::output const> outputs)
+    {
+        auto span = trace::span{"build_output_topology", "outputs"};
+        auto active = std::vector<i3_containers::output const *>{};
+        for (auto const & output : outputs) {
+            if (output.is_active) {
+                active.push_back(&output);
+            }
+        }
+        std::ranges::sort(active, [](auto const * a, auto const * b) {
+            return std::pair{a->rect.y, a->rect.x} < std::pair{b->rect.y, b->rect.x};
+        });
+
+        // Rows, from top to bottom
+        auto rows = std::vector<std::vector<i3_containers::output const *>>{};
+        auto row_bottom = std::int64_t{0};
+        for (auto const * output : active) {
+            auto const center = std::int64_t{output->rect.y} + output->rect.height / 2;
+            if (rows.empty() or center >= row_bottom) {
+                rows.emplace_back();
+                row_bottom = std::int64_t{output->rect.y} + output->rect.height;
+            }
+            rows.back().push_back(output);
+            row_bottom = std::max(row_bottom, std::int64_t{output->rect.y} + output->rect.height);
+        }
+
+        for (auto row = std::uint32_t{0}; auto & members : rows) {
+            std::ranges::sort(members, std::ranges::less{}, [](auto const * o) { return o->rect.x; });
+            for (auto column = std::uint32_t{0}; auto const * output : members) {
+                _index_of.emplace(output->name, _names.size());
+                _names.push_back(output->name);
+                _rect.push_back(output->rect);
+                _row.push_back(row);
+                _column.push_back(column++);
+                _visible.push_back(output->current_workspace.has_value()
+                    ? tl::optional<std::string>{*output->current_workspace}
+                    : tl::nullopt);
+            }
+            ++row;
+        }
+        _rows = static_cast<std::uint32_t>(rows.size());
+
+        _neighbors.resize(_names.size());
+        for (auto idx = index{0}; idx < _names.size(); ++idx) {
+            for (auto const dir : {direction::left, direction::right, direction::up, direction::down}) {
+                _neighbors[idx][static_cast<std::size_t>(dir)] = find_neighbor(idx, dir);
+            }
+        }
+        span.arg("outputs", _names.size());
+    }
+
+    [[nodiscard]] auto size()  const noexcept { return _names.size(); }
+    [[nodiscard]] bool empty() const noexcept { return _names.empty(); }
+    [[nodiscard]] auto rows()  const noexcept { return _rows; }
+
+    /// The names of the outputs, in order
+    [[nodiscard]] auto names() const noexcept -> std::span<std::string const> { return _names; }
+
+    [[nodiscard]] auto name(index idx)   const -> std::string const & { return _names.at(idx); }
+    [[nodiscard]] auto rect(index idx)   const -> rect_type const &   { return _rect.at(idx); }
+    [[nodiscard]] auto row(index idx)    const { return _row.at(idx); }
+    [[nodiscard]] auto column(index idx) const { return _column.at(idx); }
+
+    /**
+     * Search an output by name
+     * */
+    [[nodiscard]]
+    auto find(std::string_view name) const
+        -> tl::optional<index>
+    {
+        auto const found = _index_of.find(std::string{name});
+        return found != _index_of.end() ? tl::optional{found->second} : tl::nullopt;
+    }
+
+    /**
+     * The output next to `idx` in the direction `dir`
+     *
+     * \returns The output, or an empty optional if `idx` is on that border of the screen
+     * */
+    [[nodiscard]]
+    auto neighbor(index idx, direction dir) const
+        -> tl::optional<index>
+    {
+        auto const found = _neighbors.at(idx)[static_cast<std::size_t>(dir)];
+        return found != npos ? tl::optional{found} : tl::nullopt;
+    }
+
+    /// The highest workspace number that belongs to an output
+    [[nodiscard]]
+    auto max_workspace() const noexcept
+        -> int
+    {
+        return static_cast<int>(_names.size()) * per_output;
+    }
+
+    /**
+     * The output a workspace number belongs to
+     *
+     * \returns The output, or an empty optional if the number is beyond the last output
+     * */
+    [[nodiscard]]
+    auto output_of(int num) const noexcept
+        -> tl::optional<index>
+    {
+        if (num <= 0 or num > max_workspace()) {
+            return tl::nullopt;
+        }
+        return static_cast<index>((num - 1) / per_output);
+    }
+
+    /// The first workspace number belonging to the output `idx`
+    [[nodiscard]]
+    auto first_workspace(index idx) const noexcept
+        -> int
+    {
+        return static_cast<int>(idx) * per_output + 1;
+    }
+
+    /// The name of the workspace visible on the output `idx`, if any
+    [[nodiscard]]
+    auto visible_workspace(index idx) const
+        -> tl::optional<std::string> const &
+    {
+        return _visible.at(idx);
+    }
+
+    /// The number of the workspace visible on the output `idx`, if it has one
+    [[nodiscard]]
+    auto visible_num(index idx) const
+        -> tl::optional<int>
+    {
+        auto const & visible = _visible.at(idx);
+        return visible.has_value() ? brun::stoi(*visible) : tl::nullopt;
+    }
+
+    /**
+     * Search the output showing the workspace number `num`
+     * */
+    [[nodiscard]]
+    auto showing(int num) const
+        -> tl::optional<index>
+    {
+        for (auto idx = index{0}; idx < _visible.size(); ++idx) {
+            if (visible_num(idx) == num) {
+                return idx;
+            }
+        }
+        return tl::nullopt;
+    }
+
+    /**
+     * Reads the visible workspaces from the tree, where the visible workspace of an output is the
+     * focused child of its `content` container.
+     *
+     * This is what keeps a topology up to date in a long-running process, where it is built again
+     * only when the outputs change.
+     * */
+    void update_visible(i3_containers::node const & root)
+    {
+        using i3_containers::node_type;
+        for (auto const & output : root.nodes) {
+            auto const idx = output.type == node_type::output and output.name.has_value()
+                ? find(*output.name)
+                : tl::nullopt;
+            if (not idx.has_value()) {
+                continue;
+            }
+            for (auto const & content : output.nodes) {
+                if (content.type != node_type::con or content.focus.empty()) {
+                    continue;
+                }
+                auto const visible = std::ranges::find(content.nodes, content.focus.front(), &i3_containers::node::id);
+                if (visible != content.nodes.end() and visible->type == node_type::workspace and visible->name.has_value()) {
+                    _visible[*idx] = *visible->name;
+                }
+            }
+        }
+    }
+};
+
+} // namespace brun
+
+#endif /* OUTPUT_TOPOLOGY_HPP */
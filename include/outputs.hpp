@@ -13,6 +13,7 @@
 #include <tl/optional.hpp>
 #include <i3-ipc++/i3_ipc.hpp>
 
+#include "context.hpp"
 #include "detail/lippincott.hpp"
 
 namespace brun
@@ -21,74 +22,67 @@ namespace brun
 /**
  * Generates a list containing the active outputs
  *
- * \param i3 The current i3 instance
- * \returns The list of all the active outputs
+ * \param ctx The current context
+ * \returns The list of all the active outputs, in the order of `output_topology`
  * */
 [[nodiscard]]
-auto retrieve_output_list(i3_ipc const & i3)
+auto retrieve_output_list(context const & ctx)
     -> std::vector<i3_containers::output>
 {
-    auto outputs = i3.get_outputs();
-    std::ranges::sort(outputs, std::ranges::less{}, [](auto const & o) { return o.rect.x; });
-    auto active = outputs
-                | std::views::filter(&i3_containers::output::is_active)
-                ;
-    return std::vector<i3_containers::output>(
-        std::make_move_iterator(std::ranges::begin(active)),
-        std::make_move_iterator(std::ranges::end(active))
-    );
+    auto const & outputs = ctx.outputs();
+    auto result = std::vector<i3_containers::output>{};
+    for (auto const & name : ctx.output_topology().names()) {
+        if (auto const found = std::ranges::find(outputs, name, &i3_containers::output::name);
+            found != std::ranges::end(outputs))
+        {
+            result.push_back(*found);
+        }
+    }
+    return result;
 }
 
 
 /**
  * Generates the list of the active outputs names
  *
- * \param i3 The current i3 instance
- * \returns The list of all the active outputs' names
+ * \param ctx The current context
+ * \returns The list of all the active outputs' names, in the order of `output_topology`
  * */
 [[nodiscard]]
-auto retrieve_output_names(i3_ipc const & i3)
+auto retrieve_output_names(context const & ctx)
     -> std::vector<std::string>
 {
-    auto outputs = i3.get_outputs();
-    std::ranges::sort(outputs, std::ranges::less{}, [](auto const & o) { return o.rect.x; });
-    auto names = outputs
-               | std::views::filter(&i3_containers::output::is_active)
-               | std::views::transform(&i3_containers::output::name)
-               ;
-    return std::vector<std::string>(std::ranges::begin(names), std::ranges::end(names));
+    auto const names = ctx.output_topology().names();
+    return std::vector<std::string>(names.begin(), names.end());
 }
 
 
 /**
  * Given the number of a workspace, returns its output
  *
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \param n The `num` of the workspace
- * \returns An optional containing the workspace's output, or an empty optional if it was not found
+ * \returns The workspace's output, or an empty string if it was not found
  * */
-auto workspace_output(i3_ipc const & i3, int n)
+auto workspace_output(context const & ctx, int n)
     -> std::string
 {
-    auto const workspaces = i3.get_workspaces();
-    auto const found = std::ranges::find(workspaces, n, &i3_containers::workspace::num);
-    if (found != std::ranges::end(workspaces)) {
-        return found->output;
-    }
-    return "";
+    return ctx.workspaces_index().find(n)
+        .transform([](auto const & ws) { return ws.output; })
+        .value_or("");
 }
 
 
 /**
  * Search for the focused output
  *
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \returns An optional with the focused output, or an empty optional if it was not found
  * */
-auto focused_output(i3_ipc const & i3)
+auto focused_output(context const & ctx)
     -> tl::optional<std::string>
 try {
-    auto const workspaces = i3.get_workspaces();
+    auto const & workspaces = ctx.workspaces();
     auto const found = std::ranges::find_if(workspaces, &i3_containers::workspace::is_focused);
     if (found != std::ranges::end(workspaces)) {
         return found->output;
@@ -0,0 +1,234 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : placement_queue
+ * @created     : Saturday Oct 17, 2026 11:20:05 CEST
+ * @description : Pending launches of exec, matched with the windows that appear
+ * */
+
+#ifndef PLACEMENT_QUEUE_HPP
+#define PLACEMENT_QUEUE_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "command_batch.hpp"
+#include "format.h"
+#include "detail/json.hpp"
+
+namespace brun
+{
+/**
+ * A program launched by exec, whose window is still to appear
+ * */
+struct launch
+{
+    std::string program;        // the expected class or instance of the window, in lowercase
+    bool strict;                // `program` was given explicitly, and the window must match it
+    std::uint64_t split_container;     // the container focused when the program was launched
+    i3_containers::node_layout original_layout;
+    bool restore_layout;        // the split of `split_container` was changed for the window
+    std::string workspace;      // where the window belongs
+    std::chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * What identifies a new window, from its window event
+ * */
+struct window_identity
+{
+    std::uint64_t id = 0;
+    std::string window_class;   // in lowercase
+    std::string instance;       // in lowercase
+};
+
+namespace detail
+{
+[[nodiscard]] inline
+auto lowercase(std::string_view text)
+    -> std::string
+{
+    auto result = std::string{text};
+    std::ranges::transform(result, result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+} // namespace detail
+
+/**
+ * The name a window launched by `command` is expected to have: the name of the executable, as in
+ * `firefox` for `/usr/bin/firefox --private-window`, skipping `env` and its assignments
+ * */
+[[nodiscard]] inline
+auto expected_program(std::string_view command)
+    -> std::string
+{
+    auto words = std::vector<std::string_view>{};
+    for (auto pos = command.find_first_not_of(' '); pos != std::string_view::npos; ) {
+        auto const end = std::min(command.find(' ', pos), command.size());
+        words.push_back(command.substr(pos, end - pos));
+        pos = command.find_first_not_of(' ', end);
+    }
+    auto word = words.begin();
+    if (word != words.end() and (*word == "env" or word->ends_with("/env"))) {
+        ++word;
+        while (word != words.end() and (word->find('=') != std::string_view::npos or word->starts_with('-'))) {
+            ++word;
+        }
+    }
+    if (word == words.end()) {
+        return {};
+    }
+    auto const slash = word->rfind('/');
+    return detail::lowercase(slash == std::string_view::npos ? *word : word->substr(slash + 1));
+}
+
+/**
+ * Reads the identity of the container of a window event
+ * */
+[[nodiscard]] inline
+auto read_window_identity(std::string_view payload)
+    -> window_identity
+{
+    auto identity = window_identity{};
+    auto json = json::reader{payload};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key != "container") {
+            json.skip_value();
+            continue;
+        }
+        json.begin_object();
+        while (auto const field = json.next_key()) {
+            if (*field == "id") {
+                identity.id = json.read_number<std::uint64_t>();
+            }
+            else if (*field == "window_properties" and not json.read_null()) {
+                json.begin_object();
+                while (auto const property = json.next_key()) {
+                    if (*property == "class") {
+                        identity.window_class = detail::lowercase(json.read_string());
+                    }
+                    else if (*property == "instance") {
+                        identity.instance = detail::lowercase(json.read_string());
+                    }
+                    else {
+                        json.skip_value();
+                    }
+                }
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+    return identity;
+}
+
+/**
+ * The launches whose windows did not appear yet, in the order they were started.
+ *
+ * A new window belongs to the oldest launch whose program is its class or its instance; when
+ * there is none, to the oldest launch which was not given a class explicitly, since many programs
+ * are started by a name which is not their class (e.g. `i3-sensible-terminal`). Launches that see
+ * no window before their deadline expire.
+ * */
+class placement_queue
+{
+private:
+    std::deque<launch> _pending;
+
+public:
+    void push(launch l) { _pending.push_back(std::move(l)); }
+
+    [[nodiscard]] bool empty() const noexcept { return _pending.empty(); }
+    [[nodiscard]] auto size() const noexcept { return _pending.size(); }
+
+    /**
+     * Takes the launch the window belongs to
+     *
+     * \returns The launch, or an empty optional if the window was not launched by exec
+     * */
+    [[nodiscard]]
+    auto match(window_identity const & window)
+        -> tl::optional<launch>
+    {
+        auto found = std::ranges::find_if(_pending, [&window](launch const & l) {
+            return not l.program.empty() and (l.program == window.window_class or l.program == window.instance);
+        });
+        if (found == _pending.end()) {
+            found = std::ranges::find_if(_pending, [](launch const & l) { return not l.strict; });
+        }
+        if (found == _pending.end()) {
+            return tl::nullopt;
+        }
+        auto result = std::move(*found);
+        _pending.erase(found);
+        return result;
+    }
+
+    /**
+     * Takes the launches whose deadline is past
+     * */
+    [[nodiscard]]
+    auto expire(std::chrono::steady_clock::time_point now)
+        -> std::vector<launch>
+    {
+        auto expired = std::vector<launch>{};
+        auto const past = [now](launch const & l) { return l.deadline <= now; };
+        for (auto & l : _pending) {
+            if (past(l)) {
+                expired.push_back(std::move(l));
+            }
+        }
+        std::erase_if(_pending, past);
+        return expired;
+    }
+
+    /// The first deadline among the pending launches
+    [[nodiscard]]
+    auto next_deadline() const
+        -> tl::optional<std::chrono::steady_clock::time_point>
+    {
+        if (_pending.empty()) {
+            return tl::nullopt;
+        }
+        return std::ranges::min(_pending, {}, &launch::deadline).deadline;
+    }
+};
+
+/**
+ * Adds the commands putting `window` in place, and restoring the split changed for it
+ * */
+inline
+void place(command_batch & batch, launch const & l, std::uint64_t window)
+{
+    if (not l.workspace.empty()) {
+        // i3 does nothing if the window is already there
+        batch.add("[con_id={}] move to workspace {}", window, quote(l.workspace));
+    }
+    if (l.restore_layout) {
+        // As exec did when it waited for the window itself, which was focused by then
+        batch.add("[con_id={}] split {}", window, l.original_layout);
+    }
+}
+
+/**
+ * Adds the commands restoring the split of a launch whose window never appeared
+ * */
+inline
+void abandon(command_batch & batch, launch const & l)
+{
+    if (l.restore_layout) {
+        batch.add("[con_id={}] split {}", l.split_container, l.original_layout);
+    }
+}
+} // namespace brun
+
+#endif /* PLACEMENT_QUEUE_HPP */
@@ -0,0 +1,765 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : shared_state
+ * @created     : Saturday Oct 17, 2026 19:24:10 CEST
+ * @description : State of i3 published by i3_toolsd in shared memory, read by the tools without asking for it
+ * */
+
+#ifndef SHARED_STATE_HPP
+#define SHARED_STATE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "context.hpp"
+#include "lazy_tree.hpp"
+#include "marks.hpp"
+#include "output_topology.hpp"
+#include "trace.hpp"
+#include "tree_range.hpp"
+#include "utils.hpp"
+#include "detail/unique_fd.hpp"
+
+// The state is published by the daemon in a file mapped in memory by the daemon and by the tools:
+//   - the header, with the layout version, the pid of the daemon and the counters below
+//   - the payload, the encoded `state`, as 64-bit words
+// The payload is written under a seqlock: `sequence` is odd while the daemon writes it, and a tool
+//  that sees it change while copying the payload tries again, so that the daemon never waits for
+//  the tools. Every word of the file is accessed through `std::atomic_ref`.
+// The tools only write `commands`, counting the commands sent after deciding from the state: until
+//  the daemon publishes a state fetched after them, the one in the file could be out of date.
+// The daemon holds an exclusive flock on the file as long as it runs, so that a tool can tell that
+//  the state was left by a daemon which died without withdrawing it, even if its pid was reused.
+namespace brun::shared_state
+{
+/// How long the daemon waits for the events to settle before fetching the state again
+inline constexpr auto resync_delay = std::chrono::milliseconds{5};
+
+/**
+ * Returns the path of the file the state is published to, or an empty string if there is none
+ *
+ * The path can be forced with `I3_TOOLSD_STATE`; otherwise the file is in `XDG_RUNTIME_DIR`, named
+ * after the i3 socket so that each i3 session gets its own.
+ * */
+[[nodiscard]] inline
+auto path()
+    -> std::string
+{
+    if (auto const * path = std::getenv("I3_TOOLSD_STATE"); path != nullptr) {
+        return path;
+    }
+    auto const * runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir == nullptr) {
+        return {};
+    }
+    if (auto const * i3sock = std::getenv("I3SOCK"); i3sock != nullptr) {
+        auto const socket = std::string_view{i3sock};
+        return fmt::format("{}/i3_toolsd-{}.state", runtime_dir, socket.substr(socket.rfind('/') + 1));
+    }
+    return fmt::format("{}/i3_toolsd.state", runtime_dir);
+}
+
+/**
+ * What the tools can read without asking i3: enough to provide `focus_chain`, `workspaces`,
+ * `outputs` and `marks_index` to a context (see `seed`)
+ * */
+struct state
+{
+    std::vector<chain_node> focus_chain;
+    std::vector<i3_containers::workspace> workspaces;
+    std::vector<i3_containers::output> outputs;
+    brun::mark_index marks;
+};
+
+namespace detail
+{
+using brun::detail::unique_fd;
+
+// "i3ts" and the version of the layout, which changes with the encoding of the state
+inline constexpr auto magic = std::uint64_t{0x69337473'00000001};
+inline constexpr auto initial_capacity = std::size_t{4096};    // words of payload
+inline constexpr auto max_attempts = 16;
+
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+
+struct header
+{
+    std::uint64_t magic;
+    std::uint64_t pid;              // of the daemon
+    std::uint64_t sequence;         // odd while the payload is being written
+    std::uint64_t words;            // size of the payload, under the seqlock
+    std::uint64_t published;        // 0 while the state is withdrawn, under the seqlock
+    std::uint64_t commands_seen;    // the value of `commands` the payload accounts for, under the seqlock
+    std::uint64_t commands;         // commands sent by the tools, incremented by them
+    std::uint64_t reserved;
+};
+static_assert(sizeof(header) == 64);
+
+[[nodiscard]] inline
+auto atomic(std::uint64_t & word) noexcept
+{
+    return std::atomic_ref<std::uint64_t>{word};
+}
+
+/**
+ * A shared mapping of a whole file, made of the header followed by the payload
+ * */
+class mapping
+{
+private:
+    void * _address = MAP_FAILED;
+    std::size_t _size = 0;
+
+public:
+    mapping() = default;
+    mapping(int fd, std::size_t size)
+        : _address{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)}, _size{size}
+    {
+        if (_address == MAP_FAILED) {
+            throw std::system_error{errno, std::generic_category(), "mmap"};
+        }
+    }
+    mapping(mapping && other) noexcept
+        : _address{std::exchange(other._address, MAP_FAILED)}, _size{std::exchange(other._size, 0)} {}
+    mapping & operator=(mapping && other) noexcept
+    {
+        std::swap(_address, other._address);
+        std::swap(_size, other._size);
+        return *this;
+    }
+    mapping(mapping const &) = delete;
+    mapping & operator=(mapping const &) = delete;
+    ~mapping()
+    {
+        if (_address != MAP_FAILED) {
+            ::munmap(_address, _size);
+        }
+    }
+
+    [[nodiscard]] auto head() const noexcept -> header & { return *static_cast<header *>(_address); }
+    [[nodiscard]] auto payload() const noexcept -> std::uint64_t * { return reinterpret_cast<std::uint64_t *>(&head() + 1); }
+    /// The words of payload the mapping holds
+    [[nodiscard]] auto capacity() const noexcept { return (_size - sizeof(header)) / sizeof(std::uint64_t); }
+};
+
+[[nodiscard]] inline
+auto file_size(std::size_t words) noexcept
+    -> std::size_t
+{
+    return sizeof(header) + words * sizeof(std::uint64_t);
+}
+
+/**
+ * Appends the fields of the state to a buffer, in the layout of the machine
+ * */
+class state_writer
+{
+private:
+    std::vector<std::byte> _bytes;
+
+public:
+    void clear() noexcept { _bytes.clear(); }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void put(T const & value)
+    {
+        auto const * const first = reinterpret_cast<std::byte const *>(&value);
+        _bytes.insert(_bytes.end(), first, first + sizeof(T));
+    }
+
+    void put(std::string_view text)
+    {
+        put(static_cast<std::uint32_t>(text.size()));
+        auto const * const first = reinterpret_cast<std::byte const *>(text.data());
+        _bytes.insert(_bytes.end(), first, first + text.size());
+    }
+
+    void put_optional(auto const & value)
+    {
+        put(value.has_value());
+        if (value.has_value()) {
+            put(*value);
+        }
+    }
+
+    /// The size of the buffer in words, the last one padded with zeroes
+    [[nodiscard]]
+    auto words() const noexcept
+        -> std::size_t
+    {
+        return (_bytes.size() + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+    }
+
+    [[nodiscard]] auto bytes() const noexcept -> std::span<std::byte const> { return _bytes; }
+};
+
+/**
+ * Reads back the fields written by `state_writer`; reading past the end makes it fail
+ * */
+class state_reader
+{
+private:
+    std::span<std::byte const> _bytes;
+    bool _failed = false;
+
+    [[nodiscard]]
+    auto take(std::size_t size)
+        -> std::span<std::byte const>
+    {
+        if (_failed or size > _bytes.size()) {
+            _failed = true;
+            return {};
+        }
+        auto const taken = _bytes.first(size);
+        _bytes = _bytes.subspan(size);
+        return taken;
+    }
+
+public:
+    explicit state_reader(std::span<std::byte const> bytes) : _bytes{bytes} {}
+
+    [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void get(T & value)
+    {
+        if (auto const bytes = take(sizeof(T)); not bytes.empty()) {
+            std::memcpy(&value, bytes.data(), sizeof(T));
+        }
+    }
+
+    void get(std::string & text)
+    {
+        auto size = std::uint32_t{};
+        get(size);
+        auto const bytes = take(size);
+        text.assign(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+    }
+
+    template <typename Optional>
+    void get_optional(Optional & value)
+    {
+        auto has_value = false;
+        get(has_value);
+        if (has_value) {
+            get(value.emplace());
+        }
+    }
+
+    /// Reads a count of elements, failing if the rest of the buffer cannot hold them
+    [[nodiscard]]
+    auto count()
+        -> std::size_t
+    {
+        auto size = std::uint32_t{};
+        get(size);
+        if (size > _bytes.size()) {
+            _failed = true;
+            return 0;
+        }
+        return size;
+    }
+};
+
+/**
+ * The containers the focus goes through, with their position among their siblings, as
+ * `decode_focus_chain` gives them
+ * */
+[[nodiscard]] inline
+auto chain_of(i3_containers::node const & root)
+    -> std::vector<chain_node>
+{
+    auto chain = std::vector<chain_node>{};
+    i3_containers::node const * parent = nullptr;
+    for (auto const & node : brun::focus_chain(root)) {
+        auto & link = chain.emplace_back();
+        link.id = node.id;
+        link.name = node.name.has_value() ? tl::optional<std::string>{*node.name} : tl::nullopt;
+        link.type = node.type;
+        link.layout = node.layout;
+        link.rect = node.rect;
+        link.is_focused = node.is_focused;
+        link.fullscreen_mode = node.fullscreen_mode;
+        link.marks = node.marks;
+        if (parent != nullptr) {
+            auto const tiling = std::ranges::find(parent->nodes, node.id, &i3_containers::node::id);
+            link.is_floating = tiling == parent->nodes.end();
+            link.sibling_index = static_cast<std::uint32_t>(link.is_floating
+                ? std::ranges::find(parent->floating_nodes, node.id, &i3_containers::node::id) - parent->floating_nodes.begin()
+                : tiling - parent->nodes.begin());
+            link.tiling_siblings = link.is_floating ? 0 : static_cast<std::uint32_t>(parent->nodes.size());
+        }
+        parent = &node;
+    }
+    return chain;
+}
+
+/**
+ * The workspaces of the tree, as GET_WORKSPACES lists them.
+ *
+ * The urgency of the workspaces is not part of the tree, and is left unset.
+ * */
+[[nodiscard]] inline
+auto workspaces_of(i3_containers::node const & root)
+    -> std::vector<i3_containers::workspace>
+{
+    using i3_containers::node_type;
+    auto focused_id = std::uint64_t{0};
+    for (auto const & node : brun::focus_chain(root) | std::views::filter(of_type(node_type::workspace))) {
+        focused_id = node.id;
+    }
+
+    auto workspaces = std::vector<i3_containers::workspace>{};
+    for (auto const & output : root.nodes) {
+        if (output.type != node_type::output or output.name == "__i3") {
+            continue;
+        }
+        for (auto const & content : output.nodes) {
+            if (content.type != node_type::con) {
+                continue;
+            }
+            auto const visible_id = content.focus.empty() ? 0 : content.focus.front();
+            for (auto const & node : content.nodes) {
+                if (node.type != node_type::workspace) {
+                    continue;
+                }
+                auto & ws = workspaces.emplace_back();
+                ws.id = node.id;
+                // As i3 does, the workspaces without a number get -1, which the replies turn into nothing
+                if (auto const num = brun::detail::workspace_num(node.name); num.has_value() and *num >= 0) {
+                    ws.num = *num;
+                }
+                ws.name = node.name.value_or("");
+                ws.is_visible = node.id == visible_id;
+                ws.is_focused = node.id == focused_id;
+                ws.rect = node.rect;
+                ws.output = output.name.value_or("");
+            }
+        }
+    }
+    return workspaces;
+}
+
+inline
+void encode(state_writer & out, i3_containers::node const & root, brun::mark_index const & marks,
+            brun::output_topology const & topology)
+{
+    auto const chain = chain_of(root);
+    out.put(static_cast<std::uint32_t>(chain.size()));
+    for (auto const & link : chain) {
+        out.put(link.id);
+        out.put_optional(link.name);
+        out.put(link.type);
+        out.put(link.layout);
+        out.put(link.rect);
+        out.put(link.is_focused);
+        out.put(link.fullscreen_mode);
+        out.put(static_cast<std::uint32_t>(link.marks.size()));
+        for (auto const & mark : link.marks) {
+            out.put(mark);
+        }
+        out.put(link.sibling_index);
+        out.put(link.tiling_siblings);
+        out.put(link.is_floating);
+    }
+
+    auto const workspaces = workspaces_of(root);
+    out.put(static_cast<std::uint32_t>(workspaces.size()));
+    for (auto const & ws : workspaces) {
+        out.put(ws.id);
+        out.put_optional(ws.num);
+        out.put(ws.name);
+        out.put(ws.is_visible);
+        out.put(ws.is_focused);
+        out.put(ws.is_urgent);
+        out.put(ws.rect);
+        out.put(ws.output);
+    }
+
+    // Only the active outputs are part of the topology, which is all the tools look at
+    out.put(static_cast<std::uint32_t>(topology.size()));
+    for (auto idx = output_topology::index{0}; idx < topology.size(); ++idx) {
+        out.put(topology.name(idx));
+        out.put(topology.rect(idx));
+        out.put_optional(topology.visible_workspace(idx));
+    }
+
+    out.put(static_cast<std::uint32_t>(marks.size()));
+    for (auto const & [mark, location] : marks) {
+        out.put(mark);
+        out.put(location.container);
+        out.put(location.workspace);
+        out.put_optional(location.workspace_num);
+        out.put(location.output);
+    }
+}
+
+[[nodiscard]] inline
+auto decode(std::span<std::byte const> bytes)
+    -> tl::optional<state>
+{
+    auto in = state_reader{bytes};
+    auto result = state{};
+
+    result.focus_chain.resize(in.count());
+    for (auto & link : result.focus_chain) {
+        in.get(link.id);
+        in.get_optional(link.name);
+        in.get(link.type);
+        in.get(link.layout);
+        in.get(link.rect);
+        in.get(link.is_focused);
+        in.get(link.fullscreen_mode);
+        link.marks.resize(in.count());
+        for (auto & mark : link.marks) {
+            in.get(mark);
+        }
+        in.get(link.sibling_index);
+        in.get(link.tiling_siblings);
+        in.get(link.is_floating);
+    }
+
+    result.workspaces.resize(in.count());
+    for (auto & ws : result.workspaces) {
+        in.get(ws.id);
+        in.get_optional(ws.num);
+        in.get(ws.name);
+        in.get(ws.is_visible);
+        in.get(ws.is_focused);
+        in.get(ws.is_urgent);
+        in.get(ws.rect);
+        in.get(ws.output);
+    }
+
+    result.outputs.resize(in.count());
+    for (auto & output : result.outputs) {
+        in.get(output.name);
+        in.get(output.rect);
+        in.get_optional(output.current_workspace);
+        output.is_active = true;
+    }
+
+    for (auto n = in.count(); n > 0 and not in.failed(); --n) {
+        auto mark = std::string{};
+        auto location = mark_location{};
+        in.get(mark);
+        in.get(location.container);
+        in.get(location.workspace);
+        in.get_optional(location.workspace_num);
+        in.get(location.output);
+        result.marks.insert(std::move(mark), std::move(location));
+    }
+
+    if (in.failed()) {
+        return tl::nullopt;
+    }
+    return result;
+}
+
+/// Check if the daemon that published the state in `fd` is still running, i.e. it holds the lock
+[[nodiscard]] inline
+bool is_running(int fd) noexcept
+{
+    if (::flock(fd, LOCK_SH | LOCK_NB) == 0) {
+        ::flock(fd, LOCK_UN);
+        return false;
+    }
+    return errno == EWOULDBLOCK;
+}
+} // namespace detail
+
+
+/**
+ * Provides the state to a context, as if it had fetched it from i3.
+ *
+ * Like any other reply, it is dropped by the first command executed through the context.
+ * */
+inline
+void seed(context & ctx, state && published)
+{
+    ctx.set_focus_chain(std::move(published.focus_chain));
+    ctx.set_workspaces(std::move(published.workspaces));
+    ctx.set_outputs(std::move(published.outputs));
+    ctx.set_marks_index(std::move(published.marks));
+}
+
+
+/**
+ * The side of the daemon: creates the file and publishes the state in it
+ * */
+class publisher
+{
+private:
+    std::string _path;
+    detail::unique_fd _file;
+    detail::mapping _map;
+    detail::state_writer _encoded;
+    std::uint64_t _commands_seen = 0;
+    bool _published = false;
+
+    void resize(std::size_t words)
+    {
+        if (::ftruncate(_file.get(), static_cast<off_t>(detail::file_size(words))) != 0) {
+            throw std::system_error{errno, std::generic_category(), _path};
+        }
+        _map = detail::mapping{_file.get(), detail::file_size(words)};
+    }
+
+    /// Runs `write` with the sequence odd, so that the tools do not use what they read meanwhile
+    template <typename Write>
+    void write_locked(Write && write)
+    {
+        auto sequence = detail::atomic(_map.head().sequence);
+        auto const before = sequence.load(std::memory_order_relaxed);
+        sequence.store(before + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write();
+        sequence.store(before + 2, std::memory_order_release);
+    }
+
+public:
+    /**
+     * Creates the file at `path`, replacing the one left by a dead daemon, if any
+     *
+     * It must be created after `daemon::server`, which makes sure that no other daemon is running.
+     * */
+    explicit publisher(std::string path) : _path{std::move(path)}
+    {
+        ::unlink(_path.c_str());
+        _file.reset(::open(_path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600));
+        // Taken before the magic is written, so that no tool sees the state without the lock
+        if (not _file or ::flock(_file.get(), LOCK_EX) != 0) {
+            throw std::system_error{errno, std::generic_category(), _path};
+        }
+        resize(detail::initial_capacity);
+        auto & head = _map.head();
+        detail::atomic(head.pid).store(static_cast<std::uint64_t>(::getpid()), std::memory_order_relaxed);
+        // The tools ignore the file until the magic is there
+        detail::atomic(head.magic).store(detail::magic, std::memory_order_release);
+    }
+    publisher(publisher const &) = delete;
+    publisher & operator=(publisher const &) = delete;
+    ~publisher()
+    {
+        withdraw();
+        ::unlink(_path.c_str());
+    }
+
+    /// The commands the tools sent so far after reading the state
+    [[nodiscard]]
+    auto commands() const noexcept
+        -> std::uint64_t
+    {
+        return detail::atomic(_map.head().commands).load(std::memory_order_acquire);
+    }
+
+    /// The value of `commands` the state published last accounts for
+    [[nodiscard]] auto commands_seen() const noexcept { return _commands_seen; }
+
+    /**
+     * Publishes the state of the tree
+     *
+     * \param root The tree, up to date
+     * \param marks The index of the marks of `root`
+     * \param topology The topology of the outputs, with the visible workspaces up to date
+     * \param commands The value of `commands` read before the tree was fetched, or the same value
+     *                 as `commands_seen` if it was not fetched since
+     * */
+    void publish(i3_containers::node const & root, brun::mark_index const & marks,
+                 brun::output_topology const & topology, std::uint64_t commands)
+    {
+        auto span = trace::span{"publish_state", "shared_state"};
+        _encoded.clear();
+        detail::encode(_encoded, root, marks, topology);
+        auto const words = _encoded.words();
+        if (words > _map.capacity()) {
+            // Growing the file keeps what it holds: the tools that mapped it before still read it
+            //  whole, and then see that the state is too large for their mapping
+            resize(std::max(words, 2 * _map.capacity()));
+        }
+
+        // The bytes are copied in words, so that each of them is accessed atomically
+        auto padded = std::vector<std::uint64_t>(words, 0);
+        std::ranges::copy(_encoded.bytes(), reinterpret_cast<std::byte *>(padded.data()));
+        write_locked([&] {
+            auto * const payload = _map.payload();
+            for (auto i = std::size_t{0}; i < words; ++i) {
+                detail::atomic(payload[i]).store(padded[i], std::memory_order_relaxed);
+            }
+            auto & head = _map.head();
+            detail::atomic(head.words).store(words, std::memory_order_relaxed);
+            detail::atomic(head.commands_seen).store(commands, std::memory_order_relaxed);
+            detail::atomic(head.published).store(1, std::memory_order_relaxed);
+        });
+        _commands_seen = commands;
+        _published = true;
+        span.arg("bytes", _encoded.bytes().size());
+    }
+
+    /**
+     * Tells the tools not to use the state, until the next `publish`
+     * */
+    void withdraw() noexcept
+    {
+        if (not _published) {
+            return;
+        }
+        write_locked([this] { detail::atomic(_map.head().published).store(0, std::memory_order_relaxed); });
+        _published = false;
+    }
+};
+
+
+/**
+ * The side of the tools: maps the file and reads the state from it
+ * */
+class reader
+{
+private:
+    detail::unique_fd _file;    // kept open to check the lock of the daemon
+    detail::mapping _map;
+
+    reader(detail::unique_fd file, detail::mapping map) : _file{std::move(file)}, _map{std::move(map)} {}
+
+public:
+    /**
+     * Maps the state published at `path`
+     *
+     * \returns The reader, or an empty optional if there is no state published there
+     * */
+    [[nodiscard]] static
+    auto open(std::string const & path)
+        -> tl::optional<reader>
+    {
+        auto file = detail::unique_fd{::open(path.c_str(), O_RDWR | O_CLOEXEC)};
+        struct stat info{};
+        if (not file or ::fstat(file.get(), &info) != 0 or info.st_size < static_cast<off_t>(detail::file_size(1))) {
+            return tl::nullopt;
+        }
+        try {
+            auto map = detail::mapping{file.get(), static_cast<std::size_t>(info.st_size)};
+            if (detail::atomic(map.head().magic).load(std::memory_order_acquire) != detail::magic) {
+                return tl::nullopt;
+            }
+            return reader{std::move(file), std::move(map)};
+        }
+        catch (std::system_error const &) {
+            return tl::nullopt;
+        }
+    }
+
+    /**
+     * Reads the state, without waiting for the daemon if it is writing it
+     *
+     * \returns The state, or an empty optional if it is withdrawn, a tool sent commands after it was
+     *          published, the daemon is not running anymore, or it kept changing while being read
+     * */
+    [[nodiscard]]
+    auto read() const
+        -> tl::optional<state>
+    {
+        auto span = trace::span{"read_shared_state", "shared_state"};
+        auto & head = _map.head();
+        if (not detail::is_running(_file.get())) {
+            return tl::nullopt;
+        }
+        auto * const payload = _map.payload();
+        auto copy = std::vector<std::uint64_t>{};
+        for (auto attempt = 0; attempt < detail::max_attempts; ++attempt) {
+            auto const before = detail::atomic(head.sequence).load(std::memory_order_acquire);
+            if (before % 2 != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            auto const published = detail::atomic(head.published).load(std::memory_order_relaxed);
+            auto const seen = detail::atomic(head.commands_seen).load(std::memory_order_relaxed);
+            auto const words = detail::atomic(head.words).load(std::memory_order_relaxed);
+            copy.resize(std::min<std::size_t>(words, _map.capacity()));
+            for (auto i = std::size_t{0}; i < copy.size(); ++i) {
+                copy[i] = detail::atomic(payload[i]).load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (detail::atomic(head.sequence).load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+
+            auto const commands = detail::atomic(head.commands).load(std::memory_order_acquire);
+            if (published == 0 or seen != commands or words > _map.capacity()) {
+                return tl::nullopt;
+            }
+            span.arg("words", words);
+            return detail::decode(std::as_bytes(std::span{copy}));
+        }
+        return tl::nullopt;
+    }
+
+    /**
+     * Reports that commands are about to be sent after reading the state: the tools stop using it
+     * until the daemon publishes it again
+     * */
+    void commands_sent() const noexcept
+    {
+        detail::atomic(_map.head().commands).fetch_add(1, std::memory_order_release);
+    }
+};
+
+
+/**
+ * Runs a tool on the state published by the daemon, so that it only talks with i3 to send its
+ * commands
+ *
+ * \param tool The tool, taking a context and the arguments
+ * \param args The `argv` of the current process
+ * \returns An optional containing the exit status of the tool, or an empty optional if there is
+ *          no state up to date and the tool must get it in another way
+ * */
+template <typename Tool>
+[[nodiscard]]
+auto run(Tool && tool, std::span<char const * const> args)
+    -> tl::optional<int>
+{
+    if (std::getenv("I3_TOOLS_NO_DAEMON") != nullptr) {
+        return tl::nullopt;
+    }
+    auto const file = path();
+    auto const published = file.empty() ? tl::nullopt : reader::open(file);
+    auto current = published.has_value() ? published->read() : tl::nullopt;
+    if (not current.has_value()) {
+        return tl::nullopt;
+    }
+    auto i3 = brun::connect();
+    auto ctx = context{i3};
+    seed(ctx, std::move(*current));
+    // Counted before the commands reach i3, so that no tool reads the state once they did
+    ctx.set_before_commands([&published] { published->commands_sent(); });
+    return tool(ctx, args);
+}
+} // namespace brun::shared_state
+
+#endif /* SHARED_STATE_HPP */
@@ -0,0 +1,491 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : snapshot
+ * @created     : Friday Oct 16, 2026 15:31:12 CEST
+ * @description : Flat, index based copy of the i3 tree
+ * */
+
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "trace.hpp"
+#include "tree_range.hpp"
+#include "detail/i3_json.hpp"
+#include "detail/json.hpp"
+
+namespace brun
+{
+
+namespace detail
+{
+/// A container as decoded from GET_TREE, before it is placed in the snapshot
+struct decoded_container
+{
+    uint64_t id = 0;
+    uint64_t focus = 0;                 // the first id of its `focus` list, 0 if it is empty
+    decltype(i3_containers::node::rect) rect{};
+    std::uint32_t parent = 0;
+    std::uint32_t marks_begin = 0;      // its marks, in the list of the marks
+    std::uint32_t marks_end = 0;
+    i3_containers::node_type type = i3_containers::node_type::root;
+    i3_containers::node_layout layout = i3_containers::node_layout::splith;
+    i3_containers::fullscreen_mode_type fullscreen_mode = i3_containers::fullscreen_mode_type::no_fullscreen;
+    bool is_focused = false;
+    bool is_floating = false;
+};
+} // namespace detail
+
+/**
+ * A read-only copy of the i3 tree where the containers are stored in a contiguous array, in
+ * breadth-first order, so that the children of a container are always adjacent (the tiling ones
+ * first, then the floating ones).
+ *
+ * The fields needed to navigate the tree are stored as separate arrays; the containers are
+ * referred to by their index and exposed through the lightweight `node_ref` handle, which stays
+ * valid as long as the snapshot is alive.
+ *
+ * Everything is allocated from a monotonic arena owned by the snapshot, sized from the number of
+ * containers, so that building a snapshot costs a couple of allocations and dropping it releases
+ * the arena at once: nothing in it has a destructor to run.
+ * */
+class snapshot
+{
+public:
+    using index = std::uint32_t;
+    using rect_type = decltype(i3_containers::node::rect);
+    static constexpr auto npos = std::numeric_limits<index>::max();
+
+    class node_ref;
+
+private:
+    // declared first, so that it is released after everything allocated from it
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> _arena;
+    // topology
+    std::pmr::vector<index> _parent;
+    std::pmr::vector<index> _first_child;
+    std::pmr::vector<index> _next_sibling;
+    std::pmr::vector<index> _focused_child;
+    std::pmr::vector<std::uint32_t> _child_count;
+    std::pmr::vector<std::uint32_t> _tiling_count;
+    // hot fields
+    std::pmr::vector<uint64_t> _id;
+    std::pmr::vector<i3_containers::node_type> _type;
+    std::pmr::vector<i3_containers::node_layout> _layout;
+    std::pmr::vector<rect_type> _rect;
+    std::pmr::vector<std::uint8_t> _focused;
+    std::pmr::vector<i3_containers::fullscreen_mode_type> _fullscreen;
+    // cold fields
+    std::pmr::vector<std::pair<std::string_view, index>> _marks;    // the text is in the arena too, by container
+    std::pmr::vector<std::pair<uint64_t, index>> _index_of;         // open addressing, by id
+
+    /// The bytes taken by the arrays for each container, up to four slots of the table of the ids
+    static constexpr auto bytes_per_container = 4 * sizeof(index) + 2 * sizeof(std::uint32_t) + sizeof(uint64_t)
+        + sizeof(i3_containers::node_type) + sizeof(i3_containers::node_layout) + sizeof(rect_type)
+        + sizeof(std::uint8_t) + sizeof(i3_containers::fullscreen_mode_type)
+        + 4 * sizeof(std::pair<uint64_t, index>);
+
+    /// Creates the arena and the empty arrays, with room for `containers` containers
+    explicit snapshot(std::size_t containers)
+        : _arena{std::make_unique<std::pmr::monotonic_buffer_resource>(
+              // the padding of each array, and the marks
+              containers * bytes_per_container + 32 * alignof(std::max_align_t) + 1024)}
+        , _parent{_arena.get()}, _first_child{_arena.get()}, _next_sibling{_arena.get()}
+        , _focused_child{_arena.get()}, _child_count{_arena.get()}, _tiling_count{_arena.get()}
+        , _id{_arena.get()}, _type{_arena.get()}, _layout{_arena.get()}, _rect{_arena.get()}
+        , _focused{_arena.get()}, _fullscreen{_arena.get()}, _marks{_arena.get()}, _index_of{_arena.get()}
+    {
+        for_each_array([containers](auto & array) { array.reserve(containers); });
+    }
+
+    void for_each_array(auto && function)
+    {
+        function(_parent); function(_first_child); function(_next_sibling); function(_focused_child);
+        function(_child_count); function(_tiling_count);
+        function(_id); function(_type); function(_layout); function(_rect); function(_focused); function(_fullscreen);
+    }
+
+    /// Copies a string in the arena
+    auto store(std::string_view text)
+        -> std::string_view
+    {
+        auto * const data = static_cast<char *>(_arena->allocate(text.size(), 1));
+        std::memcpy(data, text.data(), text.size());
+        return {data, text.size()};
+    }
+
+    void push(detail::decoded_container const & node, index parent, index next_sibling)
+    {
+        _parent.push_back(parent);
+        _first_child.push_back(npos);
+        _next_sibling.push_back(next_sibling);
+        _focused_child.push_back(npos);
+        _child_count.push_back(0);
+        _tiling_count.push_back(0);
+        _id.push_back(node.id);
+        _type.push_back(node.type);
+        _layout.push_back(node.layout);
+        _rect.push_back(node.rect);
+        _focused.push_back(node.is_focused ? 1 : 0);
+        _fullscreen.push_back(node.fullscreen_mode);
+    }
+
+    void push(i3_containers::node const & node, index parent, index next_sibling)
+    {
+        push(detail::decoded_container{
+            .id = node.id,
+            .rect = node.rect,
+            .type = node.type,
+            .layout = node.layout,
+            .fullscreen_mode = node.fullscreen_mode,
+            .is_focused = node.is_focused,
+        }, parent, next_sibling);
+        for (auto const & mark : node.marks) {
+            _marks.emplace_back(store(mark), static_cast<index>(_id.size() - 1));
+        }
+    }
+
+    [[nodiscard]]
+    auto slot_of(uint64_t id) const noexcept
+        -> std::size_t
+    {
+        // the ids are addresses: the multiplication mixes the high bits into the low ones
+        return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ull) >> 32) & (_index_of.size() - 1);
+    }
+
+    /// Fills the table of the ids, once all the containers are in place
+    void index_ids()
+    {
+        _index_of.assign(std::bit_ceil(2 * _id.size()), {0, npos});
+        for (auto idx = index{0}; idx < _id.size(); ++idx) {
+            auto slot = slot_of(_id[idx]);
+            while (_index_of[slot].second != npos and _index_of[slot].first != _id[idx]) {
+                slot = (slot + 1) & (_index_of.size() - 1);
+            }
+            // As a hash map would, the first container with an id wins
+            if (_index_of[slot].second == npos) {
+                _index_of[slot] = {_id[idx], idx};
+            }
+        }
+    }
+
+    [[nodiscard]]
+    static auto count_containers(i3_containers::node const & root)
+        -> std::size_t
+    {
+        return static_cast<std::size_t>(std::ranges::distance(preorder(root)));
+    }
+
+    /// Reads a container and its descendants, appending them in pre-order
+    static void decode_container(json::reader & json, std::uint32_t parent, bool is_floating,
+                                 std::pmr::vector<detail::decoded_container> & containers,
+                                 std::pmr::vector<std::pmr::string> & marks)
+    {
+        auto const idx = static_cast<std::uint32_t>(containers.size());
+        containers.push_back({.parent = parent, .is_floating = is_floating});
+        json.begin_object();
+        while (auto const key = json.next_key()) {
+            // the reference is taken again each time, since the children are appended to the same array
+            auto & node = containers[idx];
+            if (*key == "id") {
+                node.id = json.read_number<uint64_t>();
+            }
+            else if (*key == "type") {
+                node.type = json::read_node_type(json);
+            }
+            else if (*key == "layout") {
+                node.layout = json::read_node_layout(json);
+            }
+            else if (*key == "rect") {
+                json::read_rect(json, node.rect);
+            }
+            else if (*key == "focused") {
+                node.is_focused = json.read_bool();
+            }
+            else if (*key == "fullscreen_mode") {
+                node.fullscreen_mode = json::read_fullscreen_mode(json);
+            }
+            else if (*key == "marks") {
+                node.marks_begin = static_cast<std::uint32_t>(marks.size());
+                json.begin_array();
+                while (json.next_element()) {
+                    json.read_string(marks.emplace_back());
+                }
+                node.marks_end = static_cast<std::uint32_t>(marks.size());
+            }
+            else if (*key == "focus") {
+                json.begin_array();
+                for (auto first = true; json.next_element(); first = false) {
+                    auto const id = json.read_number<uint64_t>();
+                    node.focus = first ? id : node.focus;
+                }
+            }
+            else if (*key == "nodes" or *key == "floating_nodes") {
+                auto const floating = *key == "floating_nodes";
+                json.begin_array();
+                while (json.next_element()) {
+                    decode_container(json, idx, floating, containers, marks);
+                }
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+
+public:
+    snapshot(snapshot &&) noexcept = default;
+    // The arrays of the target could not be released after its arena
+    snapshot & operator=(snapshot &&) = delete;
+
+    /**
+     * Builds the snapshot with a single breadth-first visit of the tree
+     * */
+    explicit snapshot(i3_containers::node const & root)
+        : snapshot{count_containers(root)}
+    {
+        auto span = trace::span{"build_snapshot", "tree"};
+        auto queue = std::vector<i3_containers::node const *>{&root};
+        queue.reserve(_id.capacity());
+        push(root, npos, npos);
+        for (auto current = std::size_t{0}; current < queue.size(); ++current) {
+            auto const & node = *queue[current];
+            auto const idx = static_cast<index>(current);
+            auto const children = node.nodes.size() + node.floating_nodes.size();
+            if (children == 0) {
+                continue;
+            }
+            auto const first = static_cast<index>(queue.size());
+            _first_child[idx] = first;
+            _child_count[idx] = static_cast<std::uint32_t>(children);
+            _tiling_count[idx] = static_cast<std::uint32_t>(node.nodes.size());
+            auto const focused_id = node.focus.empty() ? tl::nullopt : tl::optional{node.focus.front()};
+            auto i = first;
+            for (auto const * group : {&node.nodes, &node.floating_nodes}) {
+                for (auto const & child : *group) {
+                    auto const last = i + 1 == first + children;
+                    push(child, idx, last ? npos : i + 1);
+                    queue.push_back(&child);
+                    if (focused_id == child.id) {
+                        _focused_child[idx] = i;
+                    }
+                    ++i;
+                }
+            }
+        }
+        index_ids();
+        span.arg("containers", queue.size());
+    }
+
+    /**
+     * Decodes the reply to GET_TREE directly into a snapshot, without building the tree.
+     *
+     * The containers are read in the order of the text into a scratch arena, which is dropped at
+     * the end, and then laid out breadth-first in the arena of the snapshot.
+     * \param text The JSON text of the tree
+     * */
+    [[nodiscard]]
+    static auto decode(std::string_view text)
+        -> snapshot
+    {
+        auto span = trace::span{"decode_snapshot", "parse"};
+        span.arg("bytes", text.size());
+        auto scratch = std::pmr::monotonic_buffer_resource{text.size() / 4 + 1024};
+        auto containers = std::pmr::vector<detail::decoded_container>{&scratch};
+        auto marks = std::pmr::vector<std::pmr::string>{&scratch};
+        {
+            auto json = json::reader{text};
+            decode_container(json, npos, false, containers, marks);
+        }
+        auto const count = static_cast<index>(containers.size());
+
+        // The children of each container, the tiling ones first, in the order of the text
+        auto offset = std::pmr::vector<index>(count + 1, 0, &scratch);
+        auto tiling = std::pmr::vector<index>(count, 0, &scratch);
+        for (auto idx = index{1}; idx < count; ++idx) {
+            auto const & node = containers[idx];
+            ++offset[node.parent + 1];
+            tiling[node.parent] += node.is_floating ? 0 : 1;
+        }
+        for (auto idx = index{0}; idx < count; ++idx) {
+            offset[idx + 1] += offset[idx];
+        }
+        auto children = std::pmr::vector<index>(count, 0, &scratch);
+        auto filled = std::pmr::vector<index>(count, 0, &scratch);
+        for (auto const floating : {false, true}) {
+            for (auto idx = index{1}; idx < count; ++idx) {
+                auto const & node = containers[idx];
+                if (node.is_floating == floating) {
+                    children[offset[node.parent] + filled[node.parent]++] = idx;
+                }
+            }
+        }
+
+        // Then the same breadth-first visit that builds the snapshot from the tree
+        auto result = snapshot{count};
+        auto queue = std::pmr::vector<index>{&scratch};
+        queue.reserve(count);
+        auto const place = [&](index decoded, index parent, index next_sibling) {
+            auto const & node = containers[decoded];
+            result.push(node, parent, next_sibling);
+            for (auto m = node.marks_begin; m < node.marks_end; ++m) {
+                result._marks.emplace_back(result.store(marks[m]), static_cast<index>(result._id.size() - 1));
+            }
+            queue.push_back(decoded);
+        };
+        if (count != 0) {
+            place(0, npos, npos);
+        }
+        for (auto current = index{0}; current < queue.size(); ++current) {
+            auto const & node = containers[queue[current]];
+            auto const begin = offset[queue[current]];
+            auto const end = offset[queue[current] + 1];
+            if (begin == end) {
+                continue;
+            }
+            auto const first = static_cast<index>(queue.size());
+            result._first_child[current] = first;
+            result._child_count[current] = end - begin;
+            result._tiling_count[current] = tiling[queue[current]];
+            for (auto c = begin; c < end; ++c) {
+                auto const i = first + (c - begin);
+                place(children[c], current, c + 1 == end ? npos : i + 1);
+                if (node.focus != 0 and containers[children[c]].id == node.focus) {
+                    result._focused_child[current] = i;
+                }
+            }
+        }
+        result.index_ids();
+        span.arg("containers", count);
+        return result;
+    }
+
+    [[nodiscard]] auto size() const noexcept { return _id.size(); }
+    [[nodiscard]] auto root() const noexcept -> node_ref;
+
+    /**
+     * Search a container by id, in constant time
+     * */
+    [[nodiscard]] auto find(uint64_t id) const -> tl::optional<node_ref>;
+
+    /**
+     * Search the first container with the given mark
+     * */
+    [[nodiscard]] auto find_mark(std::string_view mark) const -> tl::optional<node_ref>;
+
+    /**
+     * All the marks, with the index of their container, ordered by container
+     * */
+    [[nodiscard]] auto marks() const noexcept
+        -> std::span<std::pair<std::string_view, index> const>
+    { return _marks; }
+
+    /**
+     * A handle to a container of the snapshot
+     * */
+    class node_ref
+    {
+    private:
+        snapshot const * _snapshot;
+        index _idx;
+
+        [[nodiscard]] auto ref(index idx) const -> tl::optional<node_ref>
+        {
+            return idx != npos ? tl::optional{node_ref{*_snapshot, idx}} : tl::nullopt;
+        }
+
+    public:
+        node_ref(snapshot const & snapshot, index idx) : _snapshot{&snapshot}, _idx{idx} {}
+
+        [[nodiscard]] auto idx()             const noexcept { return _idx; }
+        [[nodiscard]] auto id()              const noexcept { return _snapshot->_id[_idx]; }
+        [[nodiscard]] auto type()            const noexcept { return _snapshot->_type[_idx]; }
+        [[nodiscard]] auto layout()          const noexcept { return _snapshot->_layout[_idx]; }
+        [[nodiscard]] auto rect()            const noexcept { return _snapshot->_rect[_idx]; }
+        [[nodiscard]] auto fullscreen_mode() const noexcept { return _snapshot->_fullscreen[_idx]; }
+        [[nodiscard]] bool is_focused()      const noexcept { return _snapshot->_focused[_idx] != 0; }
+        /// The marks of the container, in the order of i3
+        [[nodiscard]] auto marks() const
+        {
+            auto const & marks = _snapshot->_marks;
+            auto const same = std::ranges::equal_range(marks, _idx, {}, &std::pair<std::string_view, index>::second);
+            return same | std::views::keys;
+        }
+
+        [[nodiscard]] auto child_count()  const noexcept { return _snapshot->_child_count[_idx]; }
+        [[nodiscard]] auto tiling_count() const noexcept { return _snapshot->_tiling_count[_idx]; }
+        [[nodiscard]] bool is_floating()  const noexcept
+        {
+            auto const parent = _snapshot->_parent[_idx];
+            return parent != npos
+               and _idx - _snapshot->_first_child[parent] >= _snapshot->_tiling_count[parent];
+        }
+
+        [[nodiscard]] auto parent()        const { return ref(_snapshot->_parent[_idx]); }
+        [[nodiscard]] auto first_child()   const { return ref(_snapshot->_first_child[_idx]); }
+        [[nodiscard]] auto next_sibling()  const { return ref(_snapshot->_next_sibling[_idx]); }
+        [[nodiscard]] auto focused_child() const { return ref(_snapshot->_focused_child[_idx]); }
+        /// The first and the last tiling children, used to check if a child is on a border
+        [[nodiscard]] auto first_tiling_child() const
+        {
+            return tiling_count() != 0 ? ref(_snapshot->_first_child[_idx]) : tl::nullopt;
+        }
+        [[nodiscard]] auto last_tiling_child() const
+        {
+            return tiling_count() != 0 ? ref(_snapshot->_first_child[_idx] + tiling_count() - 1) : tl::nullopt;
+        }
+
+        friend bool operator==(node_ref const & a, node_ref const & b) noexcept
+        { return a._snapshot == b._snapshot and a._idx == b._idx; }
+    };
+};
+
+inline
+auto snapshot::root() const noexcept
+    -> node_ref
+{
+    return node_ref{*this, 0};
+}
+
+inline
+auto snapshot::find(uint64_t id) const
+    -> tl::optional<node_ref>
+{
+    for (auto slot = slot_of(id); _index_of[slot].second != npos; slot = (slot + 1) & (_index_of.size() - 1)) {
+        if (_index_of[slot].first == id) {
+            return node_ref{*this, _index_of[slot].second};
+        }
+    }
+    return tl::nullopt;
+}
+
+inline
+auto snapshot::find_mark(std::string_view mark) const
+    -> tl::optional<node_ref>
+{
+    for (auto const & [name, idx] : _marks) {
+        if (name == mark) {
+            return node_ref{*this, idx};
+        }
+    }
+    return tl::nullopt;
+}
+
+} // namespace brun
+
+#endif /* SNAPSHOT_HPP */
@@ -0,0 +1,75 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tools
+ * @created     : Friday Oct 16, 2026 11:40:18 CEST
+ * @description : Table of all the tools, for the programs that run more than one of them
+ * */
+
+#ifndef TOOLS_HPP
+#define TOOLS_HPP
+
+#include <array>
+#include <algorithm>
+#include <span>
+#include <string_view>
+#include <i3-ipc++/i3_ipc.hpp>
+
+#include "context.hpp"
+#include "tools/exec.hpp"
+#include "tools/fix_workspaces.hpp"
+#include "tools/focus_window.hpp"
+#include "tools/focus_workspace.hpp"
+#include "tools/mv_container.hpp"
+#include "tools/mv_to_output.hpp"
+
+namespace brun::tools
+{
+struct tool
+{
+    std::string_view name;
+    int (*run)(context const & ctx, std::span<char const * const> args);
+    /// `false` for the tools that wait for events, which would stall the daemon; exec is served
+    ///  by the placement queue of the daemon, which does not wait
+    bool served_by_daemon;
+    /// The argument that makes the tool wait for events, if any (e.g. `--watch`)
+    std::string_view waits_with = {};
+    /// `true` for the tools that need nothing but the state published by the daemon, and can run
+    ///  on it without asking i3 (see `shared_state::run`)
+    bool reads_shared_state = false;
+};
+
+inline constexpr auto all = std::array{
+    tool{"exec",            &exec,            true},
+    tool{"fix_workspaces",  &fix_workspaces,  true, "--watch"},
+    tool{"focus_window",    &focus_window,    true, {}, true},
+    tool{"focus_workspace", &focus_workspace, true, {}, true},
+    tool{"mv_container",    &mv_container,    true},
+    tool{"mv_to_output",    &mv_to_output,    true},
+};
+
+/**
+ * Check if the daemon can run `t` with these arguments without being stalled
+ * */
+[[nodiscard]] inline
+bool served_by_daemon(tool const & t, std::span<char const * const> args)
+{
+    return t.served_by_daemon
+       and (t.waits_with.empty() or std::ranges::none_of(args, [&t](std::string_view arg) { return arg == t.waits_with; }));
+}
+
+/**
+ * Search a tool by name
+ *
+ * \param name The name of the tool
+ * \returns A pointer to the tool, or `nullptr` if there is no tool with that name
+ * */
+[[nodiscard]] constexpr
+auto find(std::string_view name)
+    -> tool const *
+{
+    auto const found = std::ranges::find(all, name, &tool::name);
+    return found != std::ranges::end(all) ? &*found : nullptr;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_HPP */
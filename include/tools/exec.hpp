@@ -0,0 +1,202 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : exec
+ * @created     : Friday Oct 16, 2026 10:44:05 CEST
+ * @description : executes a command splitting the screen along the widest direction
+ * */
+
+#ifndef TOOLS_EXEC_HPP
+#define TOOLS_EXEC_HPP
+
+#include <span>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/format.h>
+#include <tl/optional.hpp>
+
+#include "dry-comparisons.hpp"
+
+#include "command_batch.hpp"
+#include "event_loop.hpp"
+#include "ipc.hpp"
+#include "placement_queue.hpp"
+#include "focus_path.hpp"
+#include "nodes.hpp"
+#include "context.hpp"
+#include "workspaces.hpp"
+#include "outputs.hpp"
+#include "format.h"
+#include "trace.hpp"
+
+namespace brun::tools
+{
+template <typename Fn>
+class scope_exit
+{
+private:
+    std::optional<Fn> _fn;
+
+public:
+    scope_exit(Fn && fn) : _fn{std::move(fn)} {}
+
+    [[nodiscard]] bool enabled() const { return _fn.has_value(); }
+    void disable() { _fn.clear(); }
+
+    ~scope_exit() noexcept { (*_fn)(); }
+};
+
+namespace detail
+{
+/// How long a launched program has to show its window
+inline constexpr auto launch_timeout = std::chrono::seconds{7};
+
+/**
+ * The arguments of exec: `[--class <class>] [command...]`
+ * */
+struct exec_request
+{
+    std::string command;
+    std::string program;    // the class or instance expected for the window
+    bool strict;            // the class was given explicitly
+};
+
+[[nodiscard]] inline
+auto parse_exec_args(std::span<char const * const> args)
+    -> tl::optional<exec_request>
+{
+    auto request = exec_request{"i3-sensible-terminal", {}, false};
+    auto rest = args.subspan(std::min<std::size_t>(args.size(), 1));
+    if (not rest.empty() and rest[0] == std::string_view{"--class"}) {
+        if (rest.size() < 2) {
+            return tl::nullopt;
+        }
+        request.program = brun::detail::lowercase(rest[1]);
+        request.strict = true;
+        rest = rest.subspan(2);
+    }
+    if (not rest.empty()) {
+        request.command = fmt::to_string(fmt::join(rest, " "));
+    }
+    if (not request.strict) {
+        request.program = brun::expected_program(request.command);
+    }
+    return request;
+}
+} // namespace detail
+
+/**
+ * Splits the focused container along its widest direction and runs the command in it
+ *
+ * \returns The launch whose window is to be placed, or an empty optional if the focused container
+ *          cannot be split (stacked, tabbed, ...) and nothing was run
+ * */
+[[nodiscard]] inline
+auto start_launch(context const & ctx, detail::exec_request const & request)
+    -> tl::optional<launch>
+{
+    auto const span = trace::span{"start_launch", "tool"};
+    auto const focused_node = brun::focused_container(ctx);
+    auto const original_ws = brun::focused_workspace(ctx);
+
+    auto const [x, y, w, h] = focused_node.value().rect;
+#ifdef ENABLE_DEBUG
+    fmt::print("Current window xywh: {} {} {} {}\n", x, y, w, h);
+#endif // ENABLE_DEBUG
+
+    using i3_containers::node_layout;
+    auto const original_layout = focused_node.value().layout;
+    if (rollbear::none_of(node_layout::splith, node_layout::splitv) == original_layout) {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Don't want to split a stacked/tabbed/dockarea/output container\n");
+#endif // ENABLE_DEBUG
+        return tl::nullopt;
+    }
+    auto const new_layout = w >= h
+                          ? node_layout::splith
+                          : node_layout::splitv;
+#ifdef ENABLE_DEBUG
+    fmt::print(stderr, "Splitting {}ly\n", new_layout);
+#endif // ENABLE_DEBUG
+    auto const split_container = focused_node.value().id;
+    ctx.execute_commands(fmt::format("split {}; exec {}", new_layout, request.command));
+    return launch{
+        request.program,
+        request.strict,
+        split_container,
+        original_layout,
+        new_layout != original_layout,
+        original_ws.has_value() ? original_ws->name : std::string{},
+        std::chrono::steady_clock::now() + detail::launch_timeout,
+    };
+}
+
+/**
+ * Runs the command in `args` (or a terminal) splitting the focused container along its widest
+ * direction, and waits for the new window to move it to the original workspace and restore the
+ * original layout.
+ *
+ * The window is recognized by its class or instance, which is expected to be the name of the
+ * program unless given with `--class`; when none matches, the first new window is taken. The wait
+ * lasts at most 7 seconds, after which the original layout is restored anyway. When i3_toolsd is
+ * running it places the windows instead, so that many launches at once are told apart.
+ * */
+inline
+int exec(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"exec", "tool"};
+    auto const request = detail::parse_exec_args(args);
+    if (not request.has_value()) {
+        fmt::print(stderr, "Usage: {} [--class <class>] [command...]\n", args[0]);
+        return 1;
+    }
+
+    // Subscribed before the exec, so that the new window cannot be missed
+    auto events = ipc::connection{};
+    events.subscribe(R"(["window"])");
+    auto queue = placement_queue{};
+    if (auto pending = start_launch(ctx, *request); pending.has_value()) {
+        queue.push(std::move(*pending));
+    }
+    else {
+        return 0;
+    }
+    auto at_exit = scope_exit{[&ctx, &queue] {
+        auto batch = command_batch{};
+        for (auto const & abandoned : queue.expire(std::chrono::steady_clock::time_point::max())) {
+            brun::abandon(batch, abandoned);
+        }
+        ctx.execute(batch);
+    }};
+
+    auto loop = event_loop{};
+    auto deadline = timer{loop, [&loop] { loop.stop(); }};
+    deadline.arm(*queue.next_deadline());
+    auto message = ipc::message{};
+    loop.watch(events.fd(), [&events, &message, &loop, &ctx, &queue] {
+        events.receive(message);
+        if (not message.is_event() or message.event() != ipc::event_type::window
+                or ipc::event_change(message.payload) != "new") {
+            return;
+        }
+        auto const window = brun::read_window_identity(message.payload);
+        auto const matched = queue.match(window);
+        if (not matched.has_value()) {
+            return;
+        }
+#ifdef ENABLE_DEBUG
+        fmt::print("New window (id {}, class {}) placed\n", window.id, window.window_class);
+#endif // ENABLE_DEBUG
+        auto batch = command_batch{};
+        brun::place(batch, *matched, window.id);
+        ctx.execute(batch);
+        loop.stop();
+    });
+    // Returns when the window appears or at the deadline, whichever comes first
+    loop.run();
+    return 0;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_EXEC_HPP */
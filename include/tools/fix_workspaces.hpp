@@ -0,0 +1,134 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : fix_workspaces
+ * @created     : Friday Oct 16, 2026 10:33:20 CEST
+ * @description : move each workspace in an output depending on its index
+ * */
+
+#ifndef TOOLS_FIX_WORKSPACES_HPP
+#define TOOLS_FIX_WORKSPACES_HPP
+
+#include <chrono>
+#include <span>
+#include <string_view>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+#include <tl/optional.hpp>
+
+#include "context.hpp"
+#include "event_loop.hpp"
+#include "ipc.hpp"
+#include "output_topology.hpp"
+#include "workspace_plan.hpp"
+#include "utils.hpp"
+#include "trace.hpp"
+
+namespace brun::tools
+{
+namespace detail
+{
+/// How long the outputs and the workspaces must stay still before being fixed
+inline constexpr auto settle_time = std::chrono::milliseconds{100};
+
+/// Check if a workspace event can leave a workspace on the wrong output
+[[nodiscard]] inline
+bool moves_workspaces(std::string_view change)
+{
+    return change != "focus" and change != "urgent" and change != "empty";
+}
+
+/**
+ * Fixes the workspaces every time the outputs or the workspaces change, until i3 shuts down.
+ *
+ * Connecting a monitor produces a burst of events in a few tens of milliseconds: the workspaces are
+ * fixed only once the events stop for `settle_time`, so that the plan is computed on the final
+ * state. The process sleeps in the event loop between the bursts.
+ * */
+inline
+int watch_workspaces(context const & ctx)
+{
+    auto events = ipc::connection{};
+    events.subscribe(R"(["output","workspace","shutdown"])");
+
+    // The outputs change far less often than the workspaces: they are asked again only after an
+    //  output event
+    auto topology = tl::optional<output_topology>{};
+    auto const fix = [&ctx, &topology] {
+        auto span = trace::span{"fix_workspaces", "watch"};
+        ctx.invalidate();
+        if (not topology.has_value()) {
+            topology.emplace(ctx.output_topology());
+        }
+        auto const plan = brun::plan_workspaces(ctx.workspaces(), *topology);
+        span.arg("moves", plan.moves.size());
+        span.arg("renames", plan.renames.size());
+        return brun::apply(ctx, plan);
+    };
+    // The state could be already wrong when the watch begins
+    fix();
+
+    auto loop = event_loop{};
+    auto settle = timer{loop, fix};
+    auto event = ipc::message{};
+    loop.watch(events.fd(), [&events, &event, &loop, &settle, &topology] {
+        events.receive(event);
+        if (not event.is_event()) {
+            return;
+        }
+        switch (event.event()) {
+        case ipc::event_type::shutdown:
+            loop.stop();
+            break;
+        case ipc::event_type::workspace:
+            // The events caused by the plan itself arm the timer too, and the plan computed when it
+            //  expires is empty
+            if (moves_workspaces(ipc::event_change(event.payload))) {
+                settle.arm(settle_time);
+            }
+            break;
+        default:
+            topology.reset();
+            settle.arm(settle_time);
+        }
+    });
+    loop.run();
+    return 0;
+}
+} // namespace detail
+
+/**
+ * Puts every workspace on the output matching its number, renumbering the ones beyond the last
+ * output; the changes are computed from a single state and applied with a single message.
+ *
+ * With `--dry-run` the commands are only printed. With `--watch` the workspaces are fixed again
+ * after each change of the outputs, until i3 exits or restarts (so it is meant for `exec_always`).
+ * */
+inline
+int fix_workspaces(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"fix_workspaces", "tool"};
+    auto const flag = args.size() == 2 ? std::string_view{args[1]} : std::string_view{};
+    if (args.size() > 2 or (args.size() == 2 and flag != "--dry-run" and flag != "--watch")) {
+        fmt::print(stderr, "Usage: {} [--dry-run|--watch]\n", args[0]);
+        return 1;
+    }
+    if (flag == "--watch") {
+        return detail::watch_workspaces(ctx);
+    }
+
+    auto const plan = brun::plan_workspaces(ctx);
+    if (flag == "--dry-run") {
+        if (plan.empty()) {
+            fmt::print("Nothing to do\n");
+        }
+        auto const batch = plan.commands();
+        for (auto const & command : batch.commands()) {
+            fmt::print("{}\n", command);
+        }
+        return 0;
+    }
+    return brun::apply(ctx, plan) ? 0 : 1;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_FIX_WORKSPACES_HPP */
@@ -0,0 +1,93 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : focus_window
+ * @created     : Friday Oct 16, 2026 10:14:37 CEST
+ * @description : a wrapper for "i3-msg focus" to focus containers also in fullscreen
+ * */
+
+#ifndef TOOLS_FOCUS_WINDOW_HPP
+#define TOOLS_FOCUS_WINDOW_HPP
+
+#include <span>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+
+#include "dry-comparisons.hpp"
+
+#include "command_batch.hpp"
+#include "context.hpp"
+#include "focus_path.hpp"
+#include "nodes.hpp"
+#include "output_topology.hpp"
+#include "trace.hpp"
+
+namespace brun::tools
+{
+inline
+int focus_window(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"focus_window", "tool"};
+    if (args.size() == 1) {
+        fmt::print(stderr, "Required an argument: left, right, up, down\n");
+        return 1;
+    }
+
+    auto const direction = std::string_view{args[1]};
+
+    if (rollbear::none_of{"left", "right", "up", "down"} == direction) {
+        fmt::print(stderr, "The argument is required to be one of: left, right, up, down\n");
+        return 1;
+    }
+
+    // Everything needed about the focused container comes from a single walk of a single tree;
+    //  the outputs, needed to leave a fullscreen container on a border, are fetched in the same
+    //  round trip
+    ctx.prefetch({context::reply::focus_chain, context::reply::outputs});
+    auto const focus = brun::analyze_focus(ctx);
+    auto const focused_position = focus.has_value() ? focus->position : brun::border::unique;
+
+#ifdef ENABLE_DEBUG
+    fmt::print("Position on border: {}\n", print_border(focused_position));
+    if (focus.has_value()) {
+        fmt::print("Focused container {} on output {}\n", focus->focused, focus->output);
+    }
+#endif
+
+    // Check if the focused window in the currently focused ws is in fullscreen
+    using brun::border;
+    auto const fullscreen = focus.has_value() and focus->is_fullscreen();
+
+    auto change_screen = (direction == "left" and brun::is_on_<border::left>(focused_position))
+                      or (direction == "right" and brun::is_on_<border::right>(focused_position))
+                      or (direction == "up" and brun::is_on_<border::top>(focused_position))
+                      or (direction == "down" and brun::is_on_<border::bottom>(focused_position))
+                      ;
+    // Past the border of the screen there is no output, and i3 wraps the focus inside the same one
+    if (change_screen and fullscreen) {
+        auto const & topology = ctx.output_topology();
+        auto const dir = *brun::parse_direction(direction);
+        change_screen = topology.find(focus->output)
+            .and_then([&topology, dir](auto idx) { return topology.neighbor(idx, dir); })
+            .has_value();
+    }
+#ifdef ENABLE_DEBUG
+    fmt::print("Changing screen: {}\n", change_screen);
+#endif
+
+    // I need to toggle the fullscreen only if the fullscreen is active and if the "next" node is in
+    //  the same output as the current
+    auto switch_fs = fullscreen and not change_screen;
+
+    auto batch = brun::command_batch{};
+    if (switch_fs) {
+        batch.add("fullscreen toggle");
+    }
+    batch.add("focus {}", direction);
+    if (switch_fs) {
+        batch.add("fullscreen toggle");
+    }
+    return ctx.execute(batch) ? 0 : 1;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_FOCUS_WINDOW_HPP */
@@ -0,0 +1,118 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : focus_workspace
+ * @created     : Friday Oct 16, 2026 10:21:03 CEST
+ * @description : a tool to help focusing the right workspace on the right monitor in a multimonitor i3 setup
+ * */
+
+#ifndef TOOLS_FOCUS_WORKSPACE_HPP
+#define TOOLS_FOCUS_WORKSPACE_HPP
+
+#include <span>
+#include <algorithm>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+#ifdef ENABLE_DEBUG
+#include <fmt/ranges.h>
+#endif
+
+#include "command_batch.hpp"
+#include "context.hpp"
+#include "workspaces.hpp"
+#include "output_topology.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+namespace brun::tools
+{
+inline
+int focus_workspace(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"focus_workspace", "tool"};
+    using std::literals::operator""sv;
+    if (args.size() == 3 and args[1] == "--container"sv) {
+        // Focus the marked container itself, wherever it is
+        auto const container = brun::target_container(ctx, args[2]);
+        if (not container.has_value()) {
+            return 1;
+        }
+        return ctx.execute(brun::command_batch{}.add("[con_id={}] focus", *container)) ? 0 : 1;
+    }
+    if (args.size() != 2) {
+        fmt::print(stderr, "Usage: {0} <workspace_num|mark>\n       {0} --container <mark>\n", args[0]);
+        return 255;
+    }
+    // Everything the tool reads, fetched with a single round trip; a mark is found in the index
+    using reply = context::reply;
+    if (brun::stoi(args[1]).has_value()) {
+        ctx.prefetch({reply::workspaces, reply::outputs});
+    }
+    else {
+        ctx.prefetch({reply::marks_index, reply::workspaces, reply::outputs});
+    }
+    auto const maybe_target = brun::target_workspace(ctx, args[1]);
+    if (not maybe_target.has_value()) {
+        return 1;
+    }
+    auto const target_ws = *maybe_target;
+
+    auto const & topology = ctx.output_topology();
+    auto const current_ws = brun::focused_workspace_idx(ctx).value_or(1);
+    auto const current_output = topology.output_of(current_ws);
+    auto const target_output = topology.output_of(target_ws);
+    // The output already showing the target, if any
+    auto const showing_target = topology.showing(target_ws);
+
+#ifdef ENABLE_DEBUG
+    fmt::print(stderr, "Focused ws:   {}\n", current_ws);
+    fmt::print(stderr, "Ws to focus:   {}\n", target_ws);
+#endif
+
+    if (topology.size() < 2) {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Only workspace {} is focused\n", current_ws);
+#endif
+        ctx.execute_commands(fmt::format("workspace {}", target_ws));
+    }
+    else if (target_ws != current_ws and showing_target.has_value()) {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Swapping focus of workspaces {} and {}\n", current_ws, target_ws);
+#endif
+        ctx.execute_commands(fmt::format("workspace --no-auto-back-and-forth {}", target_ws));
+    }
+    else if (target_ws == current_ws) {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Focusing from workspace {} using back and forth\n", target_ws);
+#endif
+        ctx.execute_commands("workspace back_and_forth");
+    }
+    else if (target_output.has_value() and current_output != *target_output) {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Current output is not target output\n");
+#endif
+        // Show the target on its own output, leaving the current workspace as the one to go back to
+        auto batch = brun::command_batch{};
+        if (auto const other_focused_ws = topology.visible_num(*target_output); other_focused_ws.has_value()) {
+            batch.add("workspace --no-auto-back-and-forth {}", *other_focused_ws);
+        }
+        auto const result = ctx.execute(batch
+            .add("focus output {}", topology.name(*target_output))
+            .add("workspace --no-auto-back-and-forth {}", target_ws)
+            .add("workspace --no-auto-back-and-forth {}", current_ws)
+            .add("workspace --no-auto-back-and-forth {}", target_ws)
+        );
+        if (not result) {
+            return 1;
+        }
+    }
+    else {
+#ifdef ENABLE_DEBUG
+        fmt::print(stderr, "Current output is target output\n");
+#endif
+        ctx.execute_commands(fmt::format("workspace --no-auto-back-and-forth {}", target_ws));
+    }
+    return 0;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_FOCUS_WORKSPACE_HPP */
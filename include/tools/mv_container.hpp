@@ -0,0 +1,115 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : mv_container
+ * @created     : Friday Oct 16, 2026 10:29:45 CEST
+ * @description : moves a container in the requested workspace, eventually creating it on the right output
+ * */
+
+#ifndef TOOLS_MV_CONTAINER_HPP
+#define TOOLS_MV_CONTAINER_HPP
+
+#include <span>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+
+#include "context.hpp"
+#include "workspaces.hpp"
+#include "workspace_extra.hpp"
+#include "utils.hpp"
+#include "workspace_history.hpp"
+#include "trace.hpp"
+
+namespace brun::tools
+{
+// target  <- get target workspace
+// current <- get current workspace
+// if current == target:
+//     target <- compute the target as for back-and-forth (from the history, if there is one)
+//     if current == target:
+//         do nothing and return
+// move the container to target workspace
+// if target has exactly one child (= a new workspace has been created):
+//     fix target output
+
+inline
+int mv_container(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"mv_container", "tool"};
+    if (args.size() < 2 or args.size() > 3) {
+        fmt::print(stderr, "usage: {} <target-workspace-num|mark> [--no-auto-back-and-forth]", args[0]);
+        return 0;
+    }
+
+    // The state the move is computed from, fetched with a single round trip; a mark is found in
+    //  the tree, which gives the flat tree too
+    using reply = context::reply;
+    if (brun::stoi(args[1]).has_value()) {
+        ctx.prefetch({reply::workspaces, reply::flat_tree});
+    }
+    else {
+        ctx.prefetch({reply::tree, reply::workspaces});
+    }
+    auto const maybe_target = brun::target_workspace(ctx, args[1]);
+    if (not maybe_target.has_value()) {
+        return 1;
+    }
+    auto target = *maybe_target;
+    auto const maybe_current = brun::focused_workspace_idx(ctx);
+    if (not maybe_current.has_value()) {
+        brun::log("No workspace focused\n");
+        return 0;
+    }
+    auto const current = *maybe_current;
+
+    auto const back_and_forth = [&args] {
+        if (args.size() == 2) { return true; }
+        auto const arg = std::string_view{args[2]};
+        if (arg != "--no-auto-back-and-forth") {
+            brun::log("Unknown option {} - ignoring", arg);
+            return true;
+        }
+        return false;
+    }();
+
+    if (current == target and back_and_forth) {
+        brun::log("Target is the same as current ({}) - trying back-and-forth\n", target);
+        // The history is trusted only if it agrees with i3 on the current workspace
+        auto const * const history = ctx.history();
+        auto const up_to_date = history != nullptr
+            and history->current().and_then([](auto const & ws) { return ws.num(); }) == current;
+        auto const previous = up_to_date
+            ? history->previous().and_then([](auto const & ws) { return ws.num(); })
+            : tl::nullopt;
+        if (previous.has_value()) {
+            target = *previous;
+        }
+        else {
+            // Without a history, get the correct target by going back and forth
+            ctx.execute_commands(fmt::format("workspace {}", current));
+            target = brun::focused_workspace_idx(ctx).value();
+            ctx.execute_commands(fmt::format("workspace --no-auto-back-and-forth {}", current));
+        }
+    }
+    if (current == target) {
+        brun::log("Target is the same as current ({}) - doing nothing\n", target);
+        return 0;
+    }
+
+    auto const new_workspace = ctx.workspaces_index().find(target)
+        .transform([](auto const & ws) { return ws.id; })
+        .and_then([&ctx](auto id) { return brun::get_workspace_node(ctx, id); })
+        .transform([](auto node) { return node.child_count() == 0; })
+        .value_or(true)
+        ;
+
+    ctx.execute_commands(fmt::format("move container to workspace {}", target));
+
+    // Eventually move the new workspace to the right focus
+    if (new_workspace) {
+        brun::fix_ws_output(ctx, target);
+    }
+    return 0;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_MV_CONTAINER_HPP */
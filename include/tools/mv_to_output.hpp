@@ -0,0 +1,118 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : mv_to_output
+ * @created     : Friday Oct 16, 2026 10:38:52 CEST
+ * @license     : MIT
+ * */
+
+#ifndef TOOLS_MV_TO_OUTPUT_HPP
+#define TOOLS_MV_TO_OUTPUT_HPP
+
+#include <span>
+#include <algorithm>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+
+#include "context.hpp"
+#include "workspaces.hpp"
+#include "workspace_extra.hpp"
+#include "output_topology.hpp"
+#include "outputs.hpp"
+#include "trace.hpp"
+#include "workspace_history.hpp"
+
+namespace brun::tools
+{
+namespace detail
+{
+/**
+ * The workspace shown before `focused` on its output, according to the history of the workspaces
+ *
+ * \returns The name of the workspace, or an empty optional if there is no history, or it is not
+ *          up to date, or the workspace is not on that output anymore
+ * */
+inline
+auto previous_on_output(context const & ctx, int focused)
+    -> tl::optional<std::string>
+{
+    auto const * const history = ctx.history();
+    if (history == nullptr or history->current().and_then([](auto const & ws) { return ws.num(); }) != focused) {
+        return tl::nullopt;
+    }
+    auto const output = brun::workspace_output(ctx, focused);
+    auto const previous = history->previous_on(output);
+    if (not previous.has_value()) {
+        return tl::nullopt;
+    }
+    // Focused by name, a workspace that does not exist anymore would be created on the focused output
+    auto const num = brun::stoi(*previous);
+    auto const ws = num.has_value() ? ctx.workspaces_index().find(*num) : tl::nullopt;
+    if (not ws.has_value() or ws->name != *previous or ws->output != output) {
+        return tl::nullopt;
+    }
+    return *previous;
+}
+} // namespace detail
+
+
+/**
+ * Moves the focused workspace to the next or the previous output, at the same position (e.g. from
+ * 3 to 13), or to the nearest free number of that output if that one is taken.
+ *
+ * A workspace which is not on the output matching its number is only put in place, renumbering it
+ * first if it is beyond the last output. Either way the whole move is a single message, and the tool
+ * returns once i3 reports the workspace in its new place.
+ * */
+inline
+int mv_to_output(context const & ctx, std::span<char const * const> args)
+{
+    auto const span = trace::span{"mv_to_output", "tool"};
+    using std::literals::operator""sv;
+    if (args.size() != 2 or (args[1] != "prev"sv and args[1] != "next"sv)) {
+        fmt::print(stderr, "Usage: {} (next|prev)\n", args[0]);
+        return 255;
+    }
+    auto const arg = std::string_view{args[1]};
+
+    ctx.prefetch({context::reply::workspaces, context::reply::outputs});
+    auto const & topology = ctx.output_topology();
+    auto const focused_ws = brun::focused_workspace(ctx);
+    if (not focused_ws.has_value() or not focused_ws->num.has_value()) {
+        fmt::print(stderr, "No numbered workspace focused\n");
+        return 1;
+    }
+    auto const focused = *focused_ws->num;
+    fmt::print(stderr, "Focused ws: {}\n", focused);
+
+    // Put the workspace in place first, if it is not
+    auto transfer = brun::workspace_transfer{focused_ws->name, focused, {}, tl::nullopt};
+    transfer.num = brun::detail::renumbering(ctx, focused, topology).value_or(focused);
+    transfer.output = brun::detail::misplaced_output(focused_ws->output, transfer.num, topology).value_or("");
+    if (transfer.num != focused or not transfer.output.empty()) {
+        fmt::print(stderr, "Putting workspace {} in place as {} {}\n", focused, transfer.num, transfer.output);
+        return brun::transfer_workspace(ctx, transfer) ? 0 : 1;
+    }
+
+    auto const new_val = focused + (arg == "next" ? 10 : -10);
+    auto const new_output = topology.output_of(new_val);
+    if (not new_output.has_value()) {
+        fmt::print(stderr, "Workspace {} is already in the extremal output {}\n", focused, focused_ws->output);
+        return 0;
+    }
+    auto const first = topology.first_workspace(*new_output);
+    auto const free = ctx.workspaces_index().nearest_free(new_val, first + output_topology::per_output - 1, first);
+    if (not free.has_value()) {
+        fmt::print(stderr, "No free workspace on {}\n", topology.name(*new_output));
+        return 1;
+    }
+
+    transfer.num = *free;
+    transfer.output = topology.name(*new_output);
+    // The output left behind shows again the workspace it showed before, instead of the one i3 picks
+    transfer.restore = detail::previous_on_output(ctx, focused);
+    fmt::print(stderr, "Moving workspace {} to {} ({})\n", focused, transfer.num, transfer.output);
+    return brun::transfer_workspace(ctx, transfer) ? 0 : 1;
+}
+} // namespace brun::tools
+
+#endif /* TOOLS_MV_TO_OUTPUT_HPP */
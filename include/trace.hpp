@@ -0,0 +1,254 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : trace
+ * @created     : Saturday Oct 17, 2026 02:10:33 CEST
+ * @description : Spans of time enabled at runtime, written as Chrome trace events
+ * */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <concepts>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Tracing is enabled by setting I3_TOOLS_TRACE to the path of the file to write, where `%p` is
+//  replaced by the pid (e.g. `I3_TOOLS_TRACE=/tmp/i3_tools-%p.json`). The events are appended to
+//  the file every `max_buffered` of them and when the process exits, as a JSON array in the
+//  trace-event format read by chrome://tracing and ui.perfetto.dev, which accept the array without
+//  its closing bracket: the file of a process still running, or killed, can be opened too.
+//  When tracing is disabled a span costs a check of a boolean.
+namespace brun::trace
+{
+namespace detail
+{
+/// How many events are kept in memory before being written, so that a long-running process does
+///  not keep all of them
+inline constexpr auto max_buffered = std::size_t{4096};
+
+struct event
+{
+    std::string_view name;      // names and categories are always literals
+    std::string_view category;
+    double start_us;
+    double duration_us;
+    long thread;
+    std::string args;           // the content of the `args` object
+};
+
+[[nodiscard]] inline
+auto now_us() noexcept
+    -> double
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double, std::micro>{clock::now().time_since_epoch()}.count();
+}
+
+/// Appends `text` to `out` as the content of a JSON string
+inline
+void escape(std::string & out, std::string_view text)
+{
+    for (auto const c : text) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+            }
+            else {
+                out.push_back(c);
+            }
+        }
+    }
+}
+
+/**
+ * Collects the events of the process and writes them in batches, and when it exits
+ * */
+class recorder
+{
+private:
+    std::string _path;
+    std::mutex _mutex;
+    std::vector<event> _events;
+    std::FILE * _file = nullptr;    // opened by the first write
+    bool _failed = false;           // the file could not be opened, and the events are dropped
+    std::size_t _written = 0;
+
+    /// Appends the buffered events to the file; to be called with the mutex held
+    void write_buffered()
+    {
+        if (_path.empty() or _events.empty()) {
+            return;
+        }
+        if (_file == nullptr and not _failed) {
+            _file = std::fopen(_path.c_str(), "w");
+            _failed = _file == nullptr;
+            if (_file != nullptr) {
+                fmt::print(_file, "[\n");
+            }
+        }
+        if (_file != nullptr) {
+            auto const pid = ::getpid();
+            for (auto const & e : _events) {
+                fmt::print(_file,
+                    R"({}{{"name":"{}","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{},"args":{{{}}}}})",
+                    _written++ == 0 ? "" : ",\n",
+                    e.name, e.category, e.start_us, e.duration_us, pid, e.thread, e.args
+                );
+            }
+            std::fflush(_file);
+        }
+        _events.clear();
+    }
+
+public:
+    recorder()
+    {
+        if (auto const * path = std::getenv("I3_TOOLS_TRACE"); path != nullptr and *path != '\0') {
+            _path = path;
+            if (auto const pid = _path.find("%p"); pid != std::string::npos) {
+                _path.replace(pid, 2, std::to_string(::getpid()));
+            }
+            _events.reserve(256);
+        }
+    }
+
+    recorder(recorder const &) = delete;
+    recorder & operator=(recorder const &) = delete;
+
+    ~recorder()
+    {
+        flush();
+        if (_file != nullptr) {
+            fmt::print(_file, "\n]\n");
+            std::fclose(_file);
+        }
+    }
+
+    [[nodiscard]] bool enabled() const noexcept { return not _path.empty(); }
+
+    void add(event e)
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        _events.push_back(std::move(e));
+        if (_events.size() >= max_buffered) {
+            write_buffered();
+        }
+    }
+
+    /// Appends the events collected so far to the file, e.g. before a long-running process exits
+    void flush()
+    {
+        auto const lock = std::scoped_lock{_mutex};
+        write_buffered();
+    }
+};
+} // namespace detail
+
+/**
+ * The recorder of the process, created the first time it is needed
+ * */
+[[nodiscard]] inline
+auto recorder()
+    -> detail::recorder &
+{
+    static auto instance = detail::recorder{};
+    return instance;
+}
+
+/// Check if tracing was enabled for this process
+[[nodiscard]] inline
+bool enabled()
+{
+    return recorder().enabled();
+}
+
+/**
+ * Measures the time from its construction to its destruction.
+ *
+ * Arguments can be attached to it, and are shown with the span by the trace viewers; nothing is
+ * stored if tracing is disabled.
+ * */
+class span
+{
+private:
+    bool _enabled;
+    std::string_view _name;
+    std::string_view _category;
+    double _start = 0;
+    std::string _args;
+
+    void add_key(std::string_view key)
+    {
+        if (not _args.empty()) {
+            _args.push_back(',');
+        }
+        _args.push_back('"');
+        _args.append(key);
+        _args += "\":";
+    }
+
+public:
+    /**
+     * \param name The name of the span; must be a literal
+     * \param category The category of the span (e.g. `ipc`, `parse`, `tree`); must be a literal
+     * */
+    span(std::string_view name, std::string_view category)
+        : _enabled{trace::enabled()}, _name{name}, _category{category}
+    {
+        if (_enabled) {
+            _start = detail::now_us();
+        }
+    }
+
+    span(span const &) = delete;
+    span & operator=(span const &) = delete;
+
+    ~span()
+    {
+        if (_enabled) {
+            auto const end = detail::now_us();
+            recorder().add({_name, _category, _start, end - _start, ::syscall(SYS_gettid), std::move(_args)});
+        }
+    }
+
+    /// Check if the span is recorded, e.g. to skip computing its arguments
+    [[nodiscard]] bool enabled() const noexcept { return _enabled; }
+
+    template <std::integral Int>
+    void arg(std::string_view key, Int value)
+    {
+        if (_enabled) {
+            add_key(key);
+            fmt::format_to(std::back_inserter(_args), "{}", value);
+        }
+    }
+
+    void arg(std::string_view key, std::string_view value)
+    {
+        if (_enabled) {
+            add_key(key);
+            _args.push_back('"');
+            detail::escape(_args, value);
+            _args.push_back('"');
+        }
+    }
+};
+} // namespace brun::trace
+
+#endif /* TRACE_HPP */
@@ -0,0 +1,277 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tree_diff
+ * @created     : Saturday Oct 17, 2026 16:42:07 CEST
+ * @description : Structural differences between two snapshots of the i3 tree
+ * */
+
+#ifndef TREE_DIFF_HPP
+#define TREE_DIFF_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <tl/optional.hpp>
+
+#include "format.h"
+#include "snapshot.hpp"
+#include "trace.hpp"
+
+namespace brun
+{
+
+/**
+ * What changed in a container between two snapshots; a container can have more than one change
+ * */
+enum class tree_change_kind : std::uint8_t
+{
+    added,
+    removed,
+    reparented,     // it has another parent
+    reordered,      // it has the same parent, but it is not in the same order among its siblings
+    focus,          // it gained or lost the focus, or its focused child is another one
+    layout,
+    rect,
+    marks,
+};
+
+[[nodiscard]] constexpr
+auto to_string(tree_change_kind kind) noexcept
+    -> std::string_view
+{
+    switch (kind) {
+    case tree_change_kind::added:      return "added";
+    case tree_change_kind::removed:    return "removed";
+    case tree_change_kind::reparented: return "reparented";
+    case tree_change_kind::reordered:  return "reordered";
+    case tree_change_kind::focus:      return "focus";
+    case tree_change_kind::layout:     return "layout";
+    case tree_change_kind::rect:       return "rect";
+    case tree_change_kind::marks:      return "marks";
+    }
+    return "???";
+}
+
+/**
+ * A change of a container, with the container as it was and as it is; the handles refer to the
+ * compared snapshots, which must outlive the change
+ * */
+struct tree_change
+{
+    tree_change_kind kind;
+    uint64_t id;
+    tl::optional<snapshot::node_ref> before;    // empty if the container was added
+    tl::optional<snapshot::node_ref> after;     // empty if the container was removed
+};
+
+namespace detail
+{
+/// \exclude
+[[nodiscard]] inline
+bool same_rect(snapshot::rect_type const & a, snapshot::rect_type const & b) noexcept
+{
+    return a.x == b.x and a.y == b.y and a.width == b.width and a.height == b.height;
+}
+
+/**
+ * The positions of `keys` which are not part of one of its longest increasing subsequences, i.e.
+ * the fewest elements to move to sort it
+ *
+ * \param keys The positions of the siblings in the old snapshot, in their new order
+ * \param tails, previous Scratch buffers
+ * \param out Filled with the positions in `keys` of the elements out of order
+ * */
+inline
+void out_of_order(std::vector<snapshot::index> const & keys, std::vector<std::size_t> & tails,
+                  std::vector<std::size_t> & previous, std::vector<std::size_t> & out)
+{
+    // Most siblings keep their order
+    if (std::ranges::is_sorted(keys)) {
+        return;
+    }
+    constexpr auto none = std::numeric_limits<std::size_t>::max();
+    tails.clear();
+    previous.assign(keys.size(), none);
+    for (auto i = std::size_t{0}; i < keys.size(); ++i) {
+        auto const pos = std::ranges::lower_bound(tails, keys[i], {}, [&keys](auto t) { return keys[t]; });
+        if (pos != tails.begin()) {
+            previous[i] = *std::prev(pos);
+        }
+        if (pos == tails.end()) {
+            tails.push_back(i);
+        }
+        else {
+            *pos = i;
+        }
+    }
+    // Walked back from its last element, the subsequence is in decreasing order of position
+    auto in_order = tails.empty() ? none : tails.back();
+    for (auto i = keys.size(); i-- > 0;) {
+        if (i == in_order) {
+            in_order = previous[i];
+        }
+        else {
+            out.push_back(i);
+        }
+    }
+}
+} // namespace detail
+
+/**
+ * Compares two snapshots of the tree, matching their containers by id.
+ *
+ * Each container is looked up once in the table of the ids of the other snapshot, so the cost is
+ * linear in the containers, apart from the siblings which are not in the same order anymore: of
+ * them, only the fewest that must be moved to restore the old order are reported as reordered
+ * (a new or removed sibling does not reorder the others).
+ *
+ * \returns The changes of the containers of `after` in breadth-first order, and then the removed
+ *          ones; the changes of a container are in the order of `tree_change_kind`
+ * */
+[[nodiscard]] inline
+auto diff(snapshot const & before, snapshot const & after)
+    -> std::vector<tree_change>
+{
+    using index = snapshot::index;
+    constexpr auto npos = snapshot::npos;
+    auto span = trace::span{"tree_diff", "tree"};
+
+    // The index in `before` of each container of `after`
+    auto matched = std::vector<index>(after.size(), npos);
+    auto kept = std::vector<bool>(before.size(), false);
+    for (auto a = index{0}; a < after.size(); ++a) {
+        if (auto const old = before.find(snapshot::node_ref{after, a}.id()); old.has_value()) {
+            matched[a] = old->idx();
+            kept[old->idx()] = true;
+        }
+    }
+    // Only the containers with marks in either snapshot have their marks compared
+    auto marked = std::vector<bool>(after.size(), false);
+    for (auto const & [mark, a] : after.marks()) {
+        marked[a] = true;
+    }
+    for (auto const & [mark, b] : before.marks()) {
+        if (auto const now = after.find(snapshot::node_ref{before, b}.id()); now.has_value()) {
+            marked[now->idx()] = true;
+        }
+    }
+    auto const same = [&matched](tl::optional<snapshot::node_ref> const & b, tl::optional<snapshot::node_ref> const & a) {
+        return a.has_value() ? b.has_value() and matched[a->idx()] == b->idx() : not b.has_value();
+    };
+
+    // The siblings that stayed under the same parent, checked for their order
+    auto reordered = std::vector<bool>(after.size(), false);
+    auto siblings = std::vector<index>{};
+    auto keys = std::vector<index>{};
+    auto tails = std::vector<std::size_t>{};
+    auto previous = std::vector<std::size_t>{};
+    auto moved = std::vector<std::size_t>{};
+    for (auto a = index{0}; a < after.size(); ++a) {
+        auto const parent = snapshot::node_ref{after, a};
+        if (matched[a] == npos or parent.child_count() < 2) {
+            continue;
+        }
+        siblings.clear();
+        keys.clear();
+        // The children are adjacent
+        auto const first = parent.first_child()->idx();
+        for (auto child = first; child < first + parent.child_count(); ++child) {
+            auto const old = matched[child];
+            if (old != npos and snapshot::node_ref{before, old}.parent()->idx() == matched[a]) {
+                siblings.push_back(child);
+                keys.push_back(old);
+            }
+        }
+        moved.clear();
+        detail::out_of_order(keys, tails, previous, moved);
+        for (auto const i : moved) {
+            reordered[siblings[i]] = true;
+        }
+    }
+
+    auto changes = std::vector<tree_change>{};
+    for (auto a = index{0}; a < after.size(); ++a) {
+        auto const now = snapshot::node_ref{after, a};
+        if (matched[a] == npos) {
+            changes.push_back({tree_change_kind::added, now.id(), tl::nullopt, now});
+            continue;
+        }
+        auto const was = snapshot::node_ref{before, matched[a]};
+        auto const add = [&](tree_change_kind kind) { changes.push_back({kind, now.id(), was, now}); };
+        if (not same(was.parent(), now.parent())) {
+            add(tree_change_kind::reparented);
+        }
+        if (reordered[a]) {
+            add(tree_change_kind::reordered);
+        }
+        if (was.is_focused() != now.is_focused() or not same(was.focused_child(), now.focused_child())) {
+            add(tree_change_kind::focus);
+        }
+        if (was.layout() != now.layout()) {
+            add(tree_change_kind::layout);
+        }
+        if (not detail::same_rect(was.rect(), now.rect())) {
+            add(tree_change_kind::rect);
+        }
+        if (marked[a] and not std::ranges::equal(was.marks(), now.marks())) {
+            add(tree_change_kind::marks);
+        }
+    }
+    for (auto b = index{0}; b < before.size(); ++b) {
+        if (not kept[b]) {
+            auto const was = snapshot::node_ref{before, b};
+            changes.push_back({tree_change_kind::removed, was.id(), was, tl::nullopt});
+        }
+    }
+    span.arg("containers", after.size());
+    span.arg("changes", changes.size());
+    return changes;
+}
+
+/**
+ * A line describing a change, with the old and the new value of what changed
+ * */
+[[nodiscard]] inline
+auto describe(tree_change const & change)
+    -> std::string
+{
+    auto const rect = [](snapshot::rect_type const & r) {
+        return fmt::format("{}x{}+{}+{}", r.width, r.height, r.x, r.y);
+    };
+    auto const id_of = [](tl::optional<snapshot::node_ref> const & node) {
+        return node.has_value() ? fmt::format("{}", node->id()) : std::string{"none"};
+    };
+    auto const head = fmt::format("{:<10} {}", to_string(change.kind), change.id);
+    auto const & was = change.before;
+    auto const & now = change.after;
+    switch (change.kind) {
+    case tree_change_kind::added:
+        return fmt::format("{} in {}", head, id_of(now->parent()));
+    case tree_change_kind::removed:
+        return fmt::format("{} from {}", head, id_of(was->parent()));
+    case tree_change_kind::reparented:
+        return fmt::format("{} from {} to {}", head, id_of(was->parent()), id_of(now->parent()));
+    case tree_change_kind::reordered:
+        return fmt::format("{} in {}", head, id_of(now->parent()));
+    case tree_change_kind::focus:
+        return fmt::format("{} focused {} -> {}, focused child {} -> {}", head,
+                           was->is_focused(), now->is_focused(),
+                           id_of(was->focused_child()), id_of(now->focused_child()));
+    case tree_change_kind::layout:
+        return fmt::format("{} {} -> {}", head, was->layout(), now->layout());
+    case tree_change_kind::rect:
+        return fmt::format("{} {} -> {}", head, rect(was->rect()), rect(now->rect()));
+    case tree_change_kind::marks:
+        return fmt::format("{} [{}] -> [{}]", head, fmt::join(was->marks(), ", "), fmt::join(now->marks(), ", "));
+    }
+    return head;
+}
+
+} // namespace brun
+
+#endif /* TREE_DIFF_HPP */
@@ -0,0 +1,453 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tree_mirror
+ * @created     : Friday Oct 16, 2026 14:07:51 CEST
+ * @description : In-memory copy of the i3 tree, kept up to date with the i3 events
+ * */
+
+#ifndef TREE_MIRROR_HPP
+#define TREE_MIRROR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+
+#include "ipc.hpp"
+#include "marks.hpp"
+#include "utils.hpp"
+#include "detail/i3_json.hpp"
+#include "detail/json.hpp"
+
+namespace brun
+{
+
+/**
+ * Where i3 put the container of a window event, as far as the event tells
+ * */
+struct container_placement
+{
+    bool is_floating = false;
+    std::string output;         // empty with the versions of i3 that do not report it
+};
+
+/**
+ * Reads the placement of the container of a window event
+ * */
+[[nodiscard]] inline
+auto read_container_placement(std::string_view payload)
+    -> container_placement
+{
+    auto placement = container_placement{};
+    auto json = json::reader{payload};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key != "container") {
+            json.skip_value();
+            continue;
+        }
+        json.begin_object();
+        while (auto const field = json.next_key()) {
+            if (*field == "floating") {
+                placement.is_floating = json.read_string().ends_with("_on");
+            }
+            else if (*field == "output") {
+                placement.output = json.read_string();
+            }
+            else {
+                json.skip_value();
+            }
+        }
+    }
+    return placement;
+}
+
+namespace detail
+{
+/// \exclude
+[[nodiscard]] inline
+bool contains(i3_containers::rectangle const & outer, i3_containers::rectangle const & inner)
+{
+    return inner.width > 0 and inner.height > 0
+       and inner.x >= outer.x and inner.x + inner.width <= outer.x + outer.width
+       and inner.y >= outer.y and inner.y + inner.height <= outer.y + outer.height;
+}
+
+/**
+ * Searches a container by id, recording the path from `node` to it
+ *
+ * \param node The root of the subtree to search in
+ * \param id The id of the container
+ * \param path Filled with the containers from `node` (included) to the found one (included)
+ * \returns `true` if the container was found
+ * */
+inline
+bool find_path(i3_containers::node & node, uint64_t id, std::vector<i3_containers::node *> & path)
+{
+    path.push_back(&node);
+    if (node.id == id) {
+        return true;
+    }
+    for (auto * children : {&node.nodes, &node.floating_nodes}) {
+        for (auto & child : *children) {
+            if (find_path(child, id, path)) {
+                return true;
+            }
+        }
+    }
+    path.pop_back();
+    return false;
+}
+
+/// \exclude
+inline
+void clear_focused(i3_containers::node & node)
+{
+    node.is_focused = false;
+    for (auto & child : node.nodes) {
+        clear_focused(child);
+    }
+    for (auto & child : node.floating_nodes) {
+        clear_focused(child);
+    }
+}
+
+/// \exclude
+inline
+void remove_mark(i3_containers::node & node, std::string const & mark, uint64_t except)
+{
+    if (node.id != except) {
+        std::erase(node.marks, mark);
+    }
+    for (auto & child : node.nodes) {
+        remove_mark(child, mark, except);
+    }
+    for (auto & child : node.floating_nodes) {
+        remove_mark(child, mark, except);
+    }
+}
+
+/// \exclude
+inline
+bool remove_child(i3_containers::node & parent, uint64_t id)
+{
+    auto const has_id = [id](auto const & child) { return child.id == id; };
+    auto const removed = std::erase_if(parent.nodes, has_id) + std::erase_if(parent.floating_nodes, has_id);
+    std::erase(parent.focus, id);
+    return removed != 0;
+}
+} // namespace detail
+
+
+/**
+ * A copy of the i3 layout tree which is bootstrapped with GET_TREE and then patched with the
+ * content of the window, workspace and output events.
+ *
+ * Events which describe the change completely (focus, title, mark, fullscreen, close, workspace
+ * focus/rename/empty...) are applied in place, as are the new tiling containers which appear on the
+ * focused workspace. The others (container moves, floating toggles, new floating containers or
+ * containers placed elsewhere by the rules of i3, new workspaces, output changes, unknown events)
+ * or events referring to containers which are not in the mirror mark it as stale, and the next
+ * `sync` fetches the whole tree again. A full resync is also done periodically, so that errors in
+ * the patches cannot accumulate.
+ *
+ * The marks are indexed too, see `mark_index`.
+ *
+ * Note that the rects of the containers resized as a side effect of a structural change are only
+ * refreshed by the next resync.
+ * */
+class tree_mirror
+{
+private:
+    i3_containers::node _root;
+    mark_index _marks;
+    bool _stale = false;
+    std::size_t _patches = 0;
+    std::chrono::steady_clock::time_point _last_sync;
+
+    std::vector<i3_containers::node *> _path;  // scratch buffer for find_path
+
+    auto find(uint64_t id)
+        -> std::vector<i3_containers::node *> const &
+    {
+        _path.clear();
+        detail::find_path(_root, id, _path);
+        return _path;
+    }
+
+    void mark_stale(std::string_view reason)
+    {
+        brun::log("Tree mirror is stale: {}\n", reason);
+        _stale = true;
+    }
+
+    /// Moves the containers in `_path` to the front of their parents' focus stacks
+    void focus_path()
+    {
+        for (auto i = std::size_t{1}; i < _path.size(); ++i) {
+            auto & focus = _path[i - 1]->focus;
+            auto const id = _path[i]->id;
+            std::erase(focus, id);
+            focus.insert(focus.begin(), id);
+        }
+    }
+
+    /// Replaces the container with the same id of `updated` with `updated`
+    bool replace(i3_containers::node const & updated)
+    {
+        auto const & path = find(updated.id);
+        if (path.empty()) {
+            return false;
+        }
+        *path.back() = updated;
+        return true;
+    }
+
+    void focus(i3_containers::node const & updated)
+    {
+        detail::clear_focused(_root);
+        if (not replace(updated)) {
+            return mark_stale("focused container not found");
+        }
+        focus_path();
+    }
+
+    void insert(i3_containers::node const & created, container_placement const & placement)
+    {
+        // i3 attaches a new container right after the focused one, in the same parent, or directly
+        //  in the workspace if it is empty; but not the floating ones, nor the ones sent elsewhere by
+        //  `assign` or `for_window`, which must be found in a new tree
+        if (placement.is_floating) {
+            return mark_stale("new floating container");
+        }
+        _path.clear();
+        auto * node = &_root;
+        auto const * output = static_cast<i3_containers::node const *>(nullptr);
+        auto const * workspace = static_cast<i3_containers::node const *>(nullptr);
+        while (true) {
+            output = node->type == i3_containers::node_type::output ? node : output;
+            workspace = node->type == i3_containers::node_type::workspace ? node : workspace;
+            if (node->is_focused or node->focus.empty()) {
+                break;
+            }
+            _path.push_back(node);
+            auto const child = std::ranges::find(node->nodes, node->focus.front(), &i3_containers::node::id);
+            if (child == node->nodes.end()) {
+                return mark_stale("new container next to a floating one");
+            }
+            node = &*child;
+        }
+        if (workspace == nullptr or output == nullptr) {
+            return mark_stale("no focused workspace for the new container");
+        }
+        // Older versions of i3 do not report the output of the containers; the rect is checked anyway,
+        //  since another workspace on the same output is not visible
+        if ((not placement.output.empty() and output->name != placement.output)
+                or not detail::contains(workspace->rect, created.rect)) {
+            return mark_stale("new container not on the focused workspace");
+        }
+        if (node->type == i3_containers::node_type::workspace) {
+            node->nodes.push_back(created);
+            node->focus.push_back(created.id);
+            return;
+        }
+        if (_path.empty()) {
+            return mark_stale("no focused container for the new one");
+        }
+        auto & siblings = _path.back()->nodes;
+        auto const position = std::ranges::find(siblings, node->id, &i3_containers::node::id);
+        siblings.insert(std::next(position), created);
+        _path.back()->focus.push_back(created.id);
+    }
+
+    void remove(uint64_t id)
+    {
+        auto const path = find(id);
+        if (path.size() < 2) {
+            return mark_stale("closed container not found");
+        }
+        // i3 also closes the split containers left empty
+        auto parent = std::prev(path.end(), 2);
+        detail::remove_child(**parent, id);
+        auto const closes_when_empty = [](auto const * node) {
+            using i3_containers::node_type;
+            return (node->type == node_type::con or node->type == node_type::floating_con)
+               and node->nodes.empty() and node->floating_nodes.empty();
+        };
+        while (parent != path.begin() and closes_when_empty(*parent)) {
+            auto const empty_id = (*parent)->id;
+            // Its marks go with it, and no event tells the index
+            if (not (*parent)->marks.empty()) {
+                _marks.erase_container(empty_id);
+            }
+            --parent;
+            detail::remove_child(**parent, empty_id);
+        }
+    }
+
+public:
+    static constexpr auto max_patches = std::size_t{512};
+    static constexpr auto max_age = std::chrono::seconds{60};
+
+    explicit tree_mirror(i3_containers::node root) { resync(std::move(root)); }
+
+    /**
+     * Replaces the whole mirror with a fresh tree
+     * */
+    void resync(i3_containers::node root)
+    {
+        _root = std::move(root);
+        _marks = mark_index{_root};
+        _stale = false;
+        _patches = 0;
+        _last_sync = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Forces the next `sync` to fetch the tree again
+     * */
+    void invalidate() noexcept { _stale = true; }
+
+    /**
+     * Check if the mirror must be fetched again: because an event could not be applied, or
+     * because too many patches or too much time passed since the last resync
+     * */
+    [[nodiscard]]
+    bool needs_resync() const
+    {
+        return _stale
+            or _patches >= max_patches
+            or std::chrono::steady_clock::now() - _last_sync >= max_age;
+    }
+
+    /**
+     * Fetches the tree again if needed
+     *
+     * \returns `true` if the tree was fetched
+     * */
+    bool sync(ipc::connection & i3)
+    {
+        if (not needs_resync()) {
+            return false;
+        }
+        auto json = json::reader{i3.request_view(ipc::message_type::get_tree)};
+        resync(json::read_node(json));
+        return true;
+    }
+
+    /**
+     * The mirrored tree; it can be used with all the functions that take a root node
+     * */
+    [[nodiscard]]
+    auto tree() const noexcept
+        -> i3_containers::node const &
+    { return _root; }
+
+    /**
+     * The index of the marks of the mirrored tree
+     * */
+    [[nodiscard]]
+    auto marks() const noexcept
+        -> mark_index const &
+    { return _marks; }
+
+    /**
+     * Applies a window event
+     *
+     * \param placement Where the container of the event is (see `read_container_placement`), to
+     *                  check that a new container goes next to the focused one
+     * */
+    void apply(i3_containers::window_event const & event, container_placement const & placement)
+    {
+        patch(event, placement);
+        if (not _stale and not _marks.apply(event, _root)) {
+            mark_stale("marked container moved");
+        }
+    }
+
+    void apply(i3_containers::workspace_event const & event)
+    {
+        patch(event);
+        if (not _stale and not _marks.apply(event)) {
+            mark_stale("workspace with marks moved");
+        }
+    }
+
+    void apply([[maybe_unused]] i3_containers::output_event const & event)
+    {
+        mark_stale("output event");
+    }
+
+private:
+    void patch(i3_containers::window_event const & event, container_placement const & placement)
+    {
+        ++_patches;
+        using i3_containers::window_change;
+        if (event.change == json::unknown_change<window_change>) {
+            return mark_stale("unknown window event");
+        }
+        switch (event.change) {
+        case window_change::create:
+            return insert(event.container, placement);
+        case window_change::close:
+            return remove(event.container.id);
+        case window_change::focus:
+            return focus(event.container);
+        case window_change::mark:
+            // marks are unique, so a mark set here was removed from any other container
+            for (auto const & mark : event.container.marks) {
+                detail::remove_mark(_root, mark, event.container.id);
+            }
+            [[fallthrough]];
+        case window_change::title:
+        case window_change::fullscreen_mode:
+        case window_change::urgent:
+            if (not replace(event.container)) {
+                mark_stale("updated container not found");
+            }
+            return;
+        default:
+            // moves and floating toggles do not say where the container ended up
+            return mark_stale("structural window event");
+        }
+    }
+
+    void patch(i3_containers::workspace_event const & event)
+    {
+        ++_patches;
+        using i3_containers::workspace_change;
+        if (event.change == json::unknown_change<workspace_change>) {
+            return mark_stale("unknown workspace event");
+        }
+        if (not event.current.has_value()) {
+            return mark_stale("workspace event without workspace");
+        }
+        switch (event.change) {
+        case workspace_change::focus:
+            return focus(*event.current);
+        case workspace_change::rename:
+        case workspace_change::urgent:
+            if (not replace(*event.current)) {
+                mark_stale("updated workspace not found");
+            }
+            return;
+        case workspace_change::empty: {
+            auto const & path = find(event.current->id);
+            if (path.size() < 2) {
+                return mark_stale("emptied workspace not found");
+            }
+            detail::remove_child(*path[path.size() - 2], event.current->id);
+            return;
+        }
+        default:
+            // the output of new or moved workspaces is not part of the event
+            return mark_stale("structural workspace event");
+        }
+    }
+};
+
+} // namespace brun
+
+#endif /* TREE_MIRROR_HPP */
@@ -0,0 +1,381 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tree_range
+ * @created     : Saturday Oct 17, 2026 17:12:36 CEST
+ * @description : Ranges visiting the containers of the i3 tree, by reference and without recursion
+ * */
+
+#ifndef TREE_RANGE_HPP
+#define TREE_RANGE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+
+namespace brun
+{
+
+/*
+ * Every range yields `i3_containers::node const &`, referring to the tree it was created from,
+ * which must outlive it. The children of a container are visited as i3 lists them, the tiling ones
+ * first and then the floating ones.
+ * The ranges are lazy: the tree is visited while the range is iterated, so an algorithm that stops
+ * early (`std::ranges::find_if`, `std::views::take`, ...) does not visit the rest of it. The
+ * depth-first ones keep the path to the current container in an explicit stack, so that the depth
+ * of the tree is not limited by the call stack.
+ * */
+
+namespace detail
+{
+/// The `i`-th child of a container, counting the tiling children before the floating ones
+[[nodiscard]] inline
+auto child_at(i3_containers::node const & node, std::size_t i) noexcept
+    -> i3_containers::node const *
+{
+    if (i < node.nodes.size()) {
+        return &node.nodes[i];
+    }
+    i -= node.nodes.size();
+    return i < node.floating_nodes.size() ? &node.floating_nodes[i] : nullptr;
+}
+
+[[nodiscard]] inline
+auto child_count(i3_containers::node const & node) noexcept
+    -> std::size_t
+{
+    return node.nodes.size() + node.floating_nodes.size();
+}
+
+/// The child the focus goes to from `node`, if any
+[[nodiscard]] inline
+auto focused_child(i3_containers::node const & node)
+    -> i3_containers::node const *
+{
+    if (node.focus.empty()) {
+        return nullptr;
+    }
+    auto const id = node.focus.front();
+    for (auto const * children : {&node.nodes, &node.floating_nodes}) {
+        auto const found = std::ranges::find(*children, id, &i3_containers::node::id);
+        if (found != children->end()) {
+            return &*found;
+        }
+    }
+    return nullptr;
+}
+
+/// The common part of the iterators: they are input iterators, compared with `std::default_sentinel`
+template <typename Derived>
+struct node_iterator_base
+{
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = i3_containers::node;
+    using difference_type = std::ptrdiff_t;
+
+    void operator++(int) { ++static_cast<Derived &>(*this); }
+
+    [[nodiscard]]
+    friend bool operator==(Derived const & it, std::default_sentinel_t) noexcept
+    {
+        return it.done();
+    }
+};
+
+enum class depth_first_order : std::uint8_t { pre, post };
+
+/**
+ * Iterator of the depth-first visits: the stack holds the path from the root to the current
+ * container, with the position of the next child to visit for each of them
+ * */
+template <depth_first_order order>
+class depth_first_iterator : public node_iterator_base<depth_first_iterator<order>>
+{
+private:
+    struct frame
+    {
+        i3_containers::node const * node;
+        std::size_t next;
+    };
+    std::vector<frame> _stack;
+
+    /// Moves down to the first child of the top of the stack that was not visited yet, if any
+    bool push_next_child()
+    {
+        auto & top = _stack.back();
+        auto const * const child = child_at(*top.node, top.next);
+        if (child == nullptr) {
+            return false;
+        }
+        ++top.next;
+        _stack.push_back({child, 0});
+        return true;
+    }
+
+public:
+    depth_first_iterator() = default;
+
+    explicit depth_first_iterator(i3_containers::node const & root)
+        : _stack{{&root, 0}}
+    {
+        if constexpr (order == depth_first_order::post) {
+            while (push_next_child()) {}
+        }
+    }
+
+    [[nodiscard]] auto operator*() const -> i3_containers::node const & { return *_stack.back().node; }
+    [[nodiscard]] auto operator->() const -> i3_containers::node const * { return _stack.back().node; }
+
+    depth_first_iterator & operator++()
+    {
+        if constexpr (order == depth_first_order::pre) {
+            while (not _stack.empty() and not push_next_child()) {
+                _stack.pop_back();
+            }
+        }
+        else {
+            _stack.pop_back();
+            if (not _stack.empty()) {
+                while (push_next_child()) {}
+            }
+        }
+        return *this;
+    }
+    using node_iterator_base<depth_first_iterator>::operator++;
+
+    [[nodiscard]] bool done() const noexcept { return _stack.empty(); }
+
+    /// The depth of the current container, 0 for the root
+    [[nodiscard]] auto depth() const noexcept { return _stack.size() - 1; }
+
+    /**
+     * The containers from the root to the current one (included), as a random access range
+     * valid until the iterator is incremented
+     * */
+    [[nodiscard]]
+    auto path() const
+    {
+        return std::span{_stack} | std::views::transform([](frame const & f) -> i3_containers::node const & {
+            return *f.node;
+        });
+    }
+
+    /**
+     * Does not visit the descendants of the current container; only for the pre-order visit,
+     * where they come after it
+     * */
+    void skip_children() noexcept
+        requires (order == depth_first_order::pre)
+    {
+        _stack.back().next = child_count(*_stack.back().node);
+    }
+};
+
+/// Iterator of the breadth-first visit: the queue holds the containers seen but not visited yet
+class breadth_first_iterator : public node_iterator_base<breadth_first_iterator>
+{
+private:
+    std::vector<i3_containers::node const *> _queue;
+    std::size_t _head = 0;
+    bool _skip = false;
+
+public:
+    breadth_first_iterator() = default;
+    explicit breadth_first_iterator(i3_containers::node const & root) : _queue{&root} {}
+
+    [[nodiscard]] auto operator*() const -> i3_containers::node const & { return *_queue[_head]; }
+    [[nodiscard]] auto operator->() const -> i3_containers::node const * { return _queue[_head]; }
+
+    breadth_first_iterator & operator++()
+    {
+        auto const & node = *_queue[_head];
+        if (not _skip) {
+            for (auto const * children : {&node.nodes, &node.floating_nodes}) {
+                for (auto const & child : *children) {
+                    _queue.push_back(&child);
+                }
+            }
+        }
+        _skip = false;
+        ++_head;
+        return *this;
+    }
+    using node_iterator_base::operator++;
+
+    [[nodiscard]] bool done() const noexcept { return _head == _queue.size(); }
+
+    /// Does not visit the descendants of the current container
+    void skip_children() noexcept { _skip = true; }
+};
+
+/// Iterator following the focus, from a container down to the focused one
+class focus_iterator : public node_iterator_base<focus_iterator>
+{
+private:
+    i3_containers::node const * _node = nullptr;
+
+public:
+    focus_iterator() = default;
+    explicit focus_iterator(i3_containers::node const & root) : _node{&root} {}
+
+    [[nodiscard]] auto operator*() const -> i3_containers::node const & { return *_node; }
+    [[nodiscard]] auto operator->() const -> i3_containers::node const * { return _node; }
+
+    focus_iterator & operator++()
+    {
+        _node = _node->is_focused ? nullptr : focused_child(*_node);
+        return *this;
+    }
+    using node_iterator_base::operator++;
+
+    [[nodiscard]] bool done() const noexcept { return _node == nullptr; }
+};
+
+/// Iterator from the parent of a container up to the root, reading the path of a depth-first visit
+class ancestor_iterator : public node_iterator_base<ancestor_iterator>
+{
+private:
+    depth_first_iterator<depth_first_order::pre> _walk;
+    std::size_t _depth = 0;     // depth of the next container, plus one
+
+public:
+    ancestor_iterator() = default;
+    explicit ancestor_iterator(depth_first_iterator<depth_first_order::pre> walk)
+        : _walk{std::move(walk)}, _depth{_walk.done() ? 0 : _walk.depth()} {}
+
+    [[nodiscard]] auto operator*() const -> i3_containers::node const & { return _walk.path()[_depth - 1]; }
+    [[nodiscard]] auto operator->() const -> i3_containers::node const * { return &**this; }
+
+    ancestor_iterator & operator++()
+    {
+        --_depth;
+        return *this;
+    }
+    using node_iterator_base::operator++;
+
+    [[nodiscard]] bool done() const noexcept { return _depth == 0; }
+};
+
+/// A range made of a root and the kind of iterator visiting from there
+template <typename Iterator>
+class node_range : public std::ranges::view_interface<node_range<Iterator>>
+{
+private:
+    i3_containers::node const * _root = nullptr;
+
+public:
+    node_range() = default;
+    explicit node_range(i3_containers::node const & root) : _root{&root} {}
+
+    [[nodiscard]] auto begin() const { return Iterator{*_root}; }
+    [[nodiscard]] auto end() const noexcept { return std::default_sentinel; }
+};
+} // namespace detail
+
+
+/**
+ * The containers of the tree in pre-order: each one before its children.
+ *
+ * The iterator also gives the path from the root (`path`), and can skip the descendants of the
+ * current container (`skip_children`).
+ * */
+[[nodiscard]] inline
+auto preorder(i3_containers::node const & root)
+{
+    return detail::node_range<detail::depth_first_iterator<detail::depth_first_order::pre>>{root};
+}
+
+/**
+ * The containers of the tree in post-order: each one after its children
+ * */
+[[nodiscard]] inline
+auto postorder(i3_containers::node const & root)
+{
+    return detail::node_range<detail::depth_first_iterator<detail::depth_first_order::post>>{root};
+}
+
+/**
+ * The containers of the tree level by level, from the root down
+ * */
+[[nodiscard]] inline
+auto breadth_first(i3_containers::node const & root)
+{
+    return detail::node_range<detail::breadth_first_iterator>{root};
+}
+
+/**
+ * The containers the focus goes through, from `root` down to the focused one (included).
+ *
+ * The range stops early if the focus does not lead to a focused container, e.g. when `root` does
+ * not contain it; the last container is the focused one only if it `is_focused`.
+ * */
+[[nodiscard]] inline
+auto focus_chain(i3_containers::node const & root)
+{
+    return detail::node_range<detail::focus_iterator>{root};
+}
+
+/**
+ * The containers enclosing the container with the given id, from its parent up to `root`
+ *
+ * The container is searched when the range begins; the range is empty if it is not found.
+ * */
+class ancestors_of : public std::ranges::view_interface<ancestors_of>
+{
+private:
+    i3_containers::node const * _root = nullptr;
+    std::uint64_t _id = 0;
+
+public:
+    ancestors_of() = default;
+    ancestors_of(i3_containers::node const & root, std::uint64_t id) : _root{&root}, _id{id} {}
+
+    [[nodiscard]]
+    auto begin() const
+    {
+        auto walk = preorder(*_root).begin();
+        while (not walk.done() and walk->id != _id) {
+            ++walk;
+        }
+        return detail::ancestor_iterator{std::move(walk)};
+    }
+    [[nodiscard]] auto end() const noexcept { return std::default_sentinel; }
+};
+
+
+/*
+ * Predicates for `std::views::filter`, `std::ranges::find_if` and the like
+ * */
+
+/// Selects the containers of the given type
+[[nodiscard]] inline
+auto of_type(i3_containers::node_type type)
+{
+    return [type](i3_containers::node const & node) { return node.type == type; };
+}
+
+/// Selects the containers with the given mark
+[[nodiscard]] inline
+auto with_mark(std::string_view mark)
+{
+    return [mark](i3_containers::node const & node) { return std::ranges::find(node.marks, mark) != node.marks.end(); };
+}
+
+/// Selects the container with the given id
+[[nodiscard]] inline
+auto with_id(std::uint64_t id)
+{
+    return [id](i3_containers::node const & node) { return node.id == id; };
+}
+
+static_assert(std::ranges::view<decltype(preorder(std::declval<i3_containers::node const &>()))>);
+static_assert(std::ranges::input_range<ancestors_of>);
+
+} // namespace brun
+
+#endif /* TREE_RANGE_HPP */
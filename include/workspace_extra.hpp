@@ -9,62 +9,110 @@
 #define WORKSPACE_EXTRA_HPP
 
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
 #include <fmt/core.h>
 #include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
 
+#include "command_batch.hpp"
+#include "context.hpp"
+#include "event_loop.hpp"
+#include "ipc.hpp"
+#include "output_topology.hpp"
 #include "outputs.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
+#include "workspace_history.hpp"
+#include "workspace_plan.hpp"
 
 namespace brun
 {
 
+namespace detail
+{
+/// How long a workspace transfer waits for i3 to confirm it
+inline constexpr auto transfer_timeout = std::chrono::milliseconds{500};
+
+/**
+ * The number a workspace beyond the last output gets: the free one nearest to the same position on
+ * the last output
+ *
+ * \returns The new number, or an empty optional if the workspace is not beyond the last output or
+ *          every number is taken
+ * */
+[[nodiscard]] inline
+auto renumbering(context const & ctx, int current, output_topology const & topology)
+    -> tl::optional<int>
+{
+    auto const max_ws = topology.max_workspace();
+    if (current <= max_ws) {
+        return tl::nullopt;
+    }
+    auto const base = max_ws - 10 + (current - 1) % 10 + 1;
+    auto const free = ctx.workspaces_index().nearest_free(base, max_ws);
+    if (not free.has_value()) {
+        brun::log("No free number for workspace {}\n", current);
+    }
+    return free;
+}
+
+/**
+ * The output a workspace must be moved to, to be on the one matching its number
+ *
+ * \param current_output The output the workspace is on
+ * \param num The number of the workspace
+ * \returns The output, or an empty optional if the workspace is already there or cannot be placed
+ * */
+[[nodiscard]] inline
+auto misplaced_output(std::string_view current_output, int num, output_topology const & topology)
+    -> tl::optional<std::string>
+{
+    auto const idx = topology.output_of(num);
+    if (not idx.has_value()) {
+        brun::log("Warning - workspace {} is beyond the {} outputs\n", num, topology.size());
+        return tl::nullopt;
+    }
+    if (current_output.empty()) {
+        brun::log("Moving from unnamed output - nothing to do\n");
+        return tl::nullopt;
+    }
+    if (current_output == topology.name(*idx)) {
+        return tl::nullopt;
+    }
+    return topology.name(*idx);
+}
+} // namespace detail
+
+
 /**
  * Check the number of the current workspace.
  *
- * Check if the workspace num is in a valid range and, if not, moves it to a better value and
- * returns the new "current".
+ * Check if the workspace num is in a valid range and, if not, moves it to the nearest free number
+ * to the same position on the last output, and returns the new "current"; if every number is taken
+ * the workspace is left as it is.
  * Note that since i3 uses "-1" for unnamed monitors, that value must not be considered an error.
  * */
-auto fix_ws_number(i3_ipc const & i3, int current, auto const & monitors)
+inline
+auto fix_ws_number(context const & ctx, int current, output_topology const & topology)
     -> std::optional<int>
 {
     // If the workspace number is too high, find the nearest free workspace to the right placement
     //  and move it there
-    auto const max_ws = std::ssize(monitors) * 10;
 #ifdef ENABLE_DEBUG_LOG
-    fmt::print("Max ws is {}\n", max_ws);
-    for (auto const & monitor : monitors) {
+    fmt::print("Max ws is {}\n", topology.max_workspace());
+    for (auto const & monitor : topology.names()) {
         fmt::print(stderr, "- {}\n", monitor);
     }
 #endif
-    if (current > max_ws) {
-        auto base = max_ws - 10 + current % 10;
-
-        auto const workspaces = i3.get_workspaces();
-        for (auto const offset : std::views::iota(0)) {
-            auto const num = &i3_containers::workspace::num;
-            if (base + offset <= max_ws) {
-                if (auto found = std::ranges::find(workspaces, base + offset, num);
-                    found == std::ranges::end(workspaces))
-                {
-                    i3.execute_commands(fmt::format("rename workspace to {}", base + offset));
-                    brun::log("Moved workspace {} to {}\n", current, base + offset);
-                    return {base + offset};
-                }
-            }
-            if (base - offset > 0) {
-                if (auto found = std::ranges::find(workspaces, base - offset, num);
-                    found == std::ranges::end(workspaces))
-                {
-                    i3.execute_commands(fmt::format("rename workspace to {}", base - offset));
-                    brun::log("Moved workspace {} to {}\n", current, base - offset);
-                    return {base - offset};
-                }
-            }
-        }
+    auto const free = detail::renumbering(ctx, current, topology);
+    if (not free.has_value()) {
+        return std::nullopt;
     }
-
-    return std::nullopt;
+    ctx.execute_commands(fmt::format("rename workspace to {}", *free));
+    brun::log("Moved workspace {} to {}\n", current, *free);
+    return {*free};
 }
 
 
@@ -74,36 +122,128 @@ auto fix_ws_number(i3_ipc const & i3, int current, auto const & monitors)
  * Check if the output assigned to the workspace is compatible with its number. If it's not,
  * the workspace is moved to the right output.
  * */
-template <std::ranges::random_access_range Outputs>
-bool fix_ws_output(i3_ipc const & i3, int target, Outputs const & output_names)
+inline
+bool fix_ws_output(context const & ctx, int target, output_topology const & topology)
 {
-    auto const idx = (target - 1) / 10;
-
-    if (auto size = std::ranges::ssize(output_names); idx >= size) {
-        brun::log("Warning - attempting to access element {} of {} in output_names\n", idx, size);
+    auto const current_output = brun::workspace_output(ctx, target);
+    auto const computed_output = detail::misplaced_output(current_output, target, topology);
+    if (not computed_output.has_value()) {
         return false;
     }
+    // Selected by its whole name, since a named workspace ("3:web") does not match `^3$`
+    auto const name = ctx.workspaces_index().find(target)
+        .transform([](auto const & ws) { return ws.name; })
+        .value_or(std::to_string(target));
+    brun::log("Moving workspace {} from {} to {}\n", name, current_output, *computed_output);
+    auto batch = command_batch{};
+    batch.add("[workspace={}] move workspace to output {}", exact_match(name), quote(*computed_output));
+    ctx.execute(batch);
+    return true;
+}
 
-    auto const current_output  = brun::workspace_output(i3, target);
-    if (current_output.empty()) {
-        brun::log("Moving from unnamed output - nothing to do\n");
-        return false;
+inline
+bool fix_ws_output(context const & ctx, int current)
+{
+    ctx.prefetch({context::reply::workspaces, context::reply::outputs});
+    return fix_ws_output(ctx, current, ctx.output_topology());
+}
+
+
+/**
+ * Moving the focused workspace to another output, with a number belonging to it.
+ *
+ * All the steps (renaming, moving, showing again the previous workspace on the output left behind
+ * and focusing the moved workspace) are sent as a single message; the transfer is complete when i3
+ * reports the last change of the workspace itself.
+ * */
+struct workspace_transfer
+{
+    std::string name;                   // the current name of the workspace
+    int num;                            // its new number, replacing the one at the beginning of the name
+    std::string output;                 // where it goes, or empty to leave it where it is
+    tl::optional<std::string> restore;  // shown again on the output left behind
+
+    [[nodiscard]] auto new_name() const -> std::string { return detail::renumbered(name, num); }
+
+    [[nodiscard]]
+    auto commands() const
+        -> command_batch
+    {
+        auto const target = new_name();
+        auto batch = command_batch{};
+        if (target != name) {
+            batch.add("rename workspace {} to {}", quote(name), quote(target));
+        }
+        if (not output.empty()) {
+            batch.add("[workspace={}] move workspace to output {}", exact_match(target), quote(output));
+        }
+        if (restore.has_value()) {
+            batch.add("workspace --no-auto-back-and-forth {}", quote(*restore));
+        }
+        batch.add("workspace --no-auto-back-and-forth {}", quote(target));
+        return batch;
     }
-    auto const computed_output = output_names[idx];
 
-    if (current_output != computed_output) {
-        brun::log("Moving workspace {} from {} to {}\n", target, current_output, computed_output);
-        i3.execute_commands(fmt::format("[workspace=^{}$] move workspace to output {}", target, computed_output));
-        return true;
+    /// Check if the event is the last change of the workspace caused by the transfer
+    [[nodiscard]]
+    bool completed_by(workspace_ref_event const & event) const
+    {
+        if (not event.current.has_value() or event.current->name != new_name()) {
+            return false;
+        }
+        if (not output.empty()) {
+            // Older versions of i3 do not report the output of the containers
+            return event.change == "move" and (event.current->output.empty() or event.current->output == output);
+        }
+        return event.change == (new_name() != name ? "rename" : "focus");
     }
-    return false;
-}
+};
 
+/**
+ * Applies a transfer and waits until i3 confirms it, instead of asking again for the workspaces.
+ *
+ * A context whose events are followed by its owner (see `context::set_watched`) does not wait: the
+ * reply to the commands already comes after i3 applied them, and the owner sees their events.
+ *
+ * \param ctx The current context; a detached one only records the commands
+ * \param transfer The transfer
+ * \param timeout How long to wait for the confirmation
+ * \returns `true` if every command succeeded and the transfer was confirmed in time
+ * */
 inline
-bool fix_ws_output(i3_ipc const & i3, int current)
+bool transfer_workspace(context const & ctx, workspace_transfer const & transfer,
+                        std::chrono::milliseconds timeout = detail::transfer_timeout)
 {
-    auto const outputs = retrieve_output_names(i3);
-    return fix_ws_output(i3, current, outputs);
+    auto span = trace::span{"transfer_workspace", "command"};
+    if (ctx.is_detached() or ctx.is_watched()) {
+        return static_cast<bool>(ctx.execute(transfer.commands()));
+    }
+    // Subscribed before the commands, so that their events cannot be missed
+    auto events = ipc::connection{};
+    events.subscribe(R"(["workspace"])");
+    if (not ctx.execute(transfer.commands())) {
+        return false;
+    }
+
+    auto confirmed = false;
+    auto loop = event_loop{};
+    auto deadline = timer{loop, [&loop] { loop.stop(); }};
+    deadline.arm(timeout);
+    auto message = ipc::message{};
+    loop.watch(events.fd(), [&events, &message, &loop, &transfer, &confirmed] {
+        events.receive(message);
+        if (message.is_event() and message.event() == ipc::event_type::workspace
+                and transfer.completed_by(read_workspace_ref_event(message.payload))) {
+            confirmed = true;
+            loop.stop();
+        }
+    });
+    loop.run();
+    span.arg("confirmed", confirmed);
+    if (not confirmed) {
+        brun::log("Workspace {} not confirmed after {} ms\n", transfer.new_name(), timeout.count());
+    }
+    return confirmed;
 }
 
 } // namespace brun
@@ -0,0 +1,272 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : workspace_history
+ * @created     : Saturday Oct 17, 2026 15:48:03 CEST
+ * @description : Most recently used workspaces, globally and on each output, kept with the workspace events
+ * */
+
+#ifndef WORKSPACE_HISTORY_HPP
+#define WORKSPACE_HISTORY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "utils.hpp"
+#include "detail/json.hpp"
+
+namespace brun
+{
+
+/**
+ * A workspace as seen by the history
+ * */
+struct workspace_ref
+{
+    std::uint64_t id = 0;   // 0 once the workspace does not exist anymore
+    std::string name;
+    std::string output;
+
+    /// The number of the workspace, as i3 computes it from the name
+    [[nodiscard]] auto num() const -> tl::optional<int> { return brun::stoi(name); }
+};
+
+namespace detail
+{
+/**
+ * Reads the fields of a container needed by the history, from the `current` or `old` member of a
+ * workspace event
+ * */
+[[nodiscard]] inline
+auto read_workspace_ref(json::reader & json)
+    -> workspace_ref
+{
+    auto ws = workspace_ref{};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "id") {
+            ws.id = json.read_number<std::uint64_t>();
+        }
+        else if (*key == "name" and not json.read_null()) {
+            ws.name = json.read_string();
+        }
+        else if (*key == "output" and not json.read_null()) {
+            ws.output = json.read_string();
+        }
+        else {
+            json.skip_value();
+        }
+    }
+    return ws;
+}
+} // namespace detail
+
+/**
+ * The change of a workspace event, and the workspace it is about
+ * */
+struct workspace_ref_event
+{
+    std::string change;
+    tl::optional<workspace_ref> current;
+};
+
+/**
+ * Reads a workspace event, keeping only what the history needs
+ * */
+[[nodiscard]] inline
+auto read_workspace_ref_event(std::string_view payload)
+    -> workspace_ref_event
+{
+    auto event = workspace_ref_event{};
+    auto json = json::reader{payload};
+    json.begin_object();
+    while (auto const key = json.next_key()) {
+        if (*key == "change") {
+            event.change = json.read_string();
+        }
+        else if (*key == "current" and not json.read_null()) {
+            event.current = detail::read_workspace_ref(json);
+        }
+        else {
+            json.skip_value();
+        }
+    }
+    return event;
+}
+
+/**
+ * The workspaces in the order they were last focused, most recent first, both globally and for each
+ * output.
+ *
+ * It is kept by a process watching the workspace events (see `apply`), so that the tools can find
+ * where back-and-forth goes, or which workspace an output showed last, without asking i3. Only the
+ * last `capacity` workspaces are remembered. A workspace that is closed because it is empty stays
+ * in the history, since i3 creates it again when it is focused by name.
+ * */
+class workspace_history
+{
+public:
+    static constexpr auto capacity = std::size_t{32};
+
+private:
+    std::vector<workspace_ref> _global;
+    std::unordered_map<std::string, std::vector<std::string>> _by_output;
+
+    template <typename T, typename Pred>
+    static void push_front(std::vector<T> & list, T value, Pred && same)
+    {
+        std::erase_if(list, same);
+        list.insert(list.begin(), std::move(value));
+        if (list.size() > capacity) {
+            list.pop_back();
+        }
+    }
+
+    void forget_on_output(std::string const & output, std::string const & name)
+    {
+        if (auto const found = _by_output.find(output); found != _by_output.end()) {
+            std::erase(found->second, name);
+        }
+    }
+
+    [[nodiscard]]
+    auto find_id(std::uint64_t id)
+        -> workspace_ref *
+    {
+        auto const found = std::ranges::find(_global, id, &workspace_ref::id);
+        return id != 0 and found != _global.end() ? &*found : nullptr;
+    }
+
+public:
+    workspace_history() = default;
+
+    /**
+     * Starts the history from the current state: the visible workspaces first, the focused one on top
+     *
+     * \param workspaces The reply to GET_WORKSPACES
+     * */
+    explicit workspace_history(std::span<i3_containers::workspace const> workspaces)
+    {
+        for (auto const & ws : workspaces) {
+            if (ws.is_visible and not ws.is_focused) {
+                focus({ws.id, ws.name, ws.output});
+            }
+        }
+        for (auto const & ws : workspaces) {
+            if (ws.is_focused) {
+                focus({ws.id, ws.name, ws.output});
+            }
+        }
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return _global.empty(); }
+
+    /**
+     * Records that a workspace has been focused
+     * */
+    void focus(workspace_ref ws)
+    {
+        if (not ws.output.empty()) {
+            auto & on_output = _by_output[ws.output];
+            push_front(on_output, ws.name, [&ws](std::string const & name) { return name == ws.name; });
+        }
+        auto const name = ws.name;
+        push_front(_global, std::move(ws), [&name](workspace_ref const & other) { return other.name == name; });
+    }
+
+    /**
+     * Applies a workspace event: focus, rename, move and empty change the history
+     *
+     * \param payload The payload of the event
+     * \returns `true` if the history changed
+     * */
+    bool apply(std::string_view payload)
+    {
+        auto [change, current] = read_workspace_ref_event(payload);
+        if (not current.has_value()) {
+            return false;
+        }
+
+        if (change == "focus") {
+            focus(std::move(*current));
+            return true;
+        }
+        auto * const known = find_id(current->id);
+        if (known == nullptr) {
+            return false;
+        }
+        if (change == "rename") {
+            if (auto const found = _by_output.find(known->output); found != _by_output.end()) {
+                std::ranges::replace(found->second, known->name, current->name);
+            }
+            known->name = current->name;
+            return true;
+        }
+        if (change == "move" and not current->output.empty()) {
+            forget_on_output(known->output, known->name);
+            push_front(_by_output[current->output], known->name,
+                       [known](std::string const & name) { return name == known->name; });
+            known->output = current->output;
+            return true;
+        }
+        if (change == "empty") {
+            known->id = 0;
+            return true;
+        }
+        return false;
+    }
+
+    /// The focused workspace
+    [[nodiscard]]
+    auto current() const
+        -> tl::optional<workspace_ref const &>
+    {
+        return _global.empty() ? tl::nullopt : tl::optional<workspace_ref const &>{_global.front()};
+    }
+
+    /// The workspace focused before the current one, where `workspace back_and_forth` goes
+    [[nodiscard]]
+    auto previous() const
+        -> tl::optional<workspace_ref const &>
+    {
+        return _global.size() < 2 ? tl::nullopt : tl::optional<workspace_ref const &>{_global[1]};
+    }
+
+    /// The workspace focused last on `output`, usually the one it shows
+    [[nodiscard]]
+    auto last_on(std::string_view output) const
+        -> tl::optional<std::string const &>
+    {
+        return nth_on(output, 0);
+    }
+
+    /// The workspace focused on `output` before the last one
+    [[nodiscard]]
+    auto previous_on(std::string_view output) const
+        -> tl::optional<std::string const &>
+    {
+        return nth_on(output, 1);
+    }
+
+    /// The `n`-th most recent workspace on `output`, counting from 0
+    [[nodiscard]]
+    auto nth_on(std::string_view output, std::size_t n) const
+        -> tl::optional<std::string const &>
+    {
+        auto const found = _by_output.find(std::string{output});
+        if (found == _by_output.end() or found->second.size() <= n) {
+            return tl::nullopt;
+        }
+        return found->second[n];
+    }
+};
+
+} // namespace brun
+
+#endif /* WORKSPACE_HISTORY_HPP */
@@ -0,0 +1,244 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : workspace_index
+ * @created     : Saturday Oct 17, 2026 13:41:22 CEST
+ * @description : Lookup tables of the workspaces by number and by id, and of the numbers in use
+ * */
+
+#ifndef WORKSPACE_INDEX_HPP
+#define WORKSPACE_INDEX_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "trace.hpp"
+
+namespace brun
+{
+
+/**
+ * Indexes the workspaces of a GET_WORKSPACES reply, so that finding a workspace by number or by id
+ * is a single lookup, and finding a free number is a bit scan.
+ *
+ * The numbers are grouped by the output they belong to: number N goes to the output (N - 1) / 10,
+ * so each output owns ten numbers, whose occupation is kept as a 10-bit mask.
+ * The index refers to the workspaces it was built from, which must outlive it.
+ * */
+class workspace_index
+{
+public:
+    using workspace = i3_containers::workspace;
+    using mask = std::uint16_t;
+    static constexpr auto per_output = 10;
+    static constexpr auto all_free = mask{(1u << per_output) - 1};
+    // Numbers up to this are looked up in a dense array, the others in a hash map
+    static constexpr auto dense_limit = 1024;
+
+private:
+    static constexpr auto none = std::int32_t{-1};
+
+    std::span<workspace const> _workspaces;
+    std::vector<std::int32_t> _by_num;                      // position of the workspace of each number
+    std::unordered_map<int, std::int32_t> _sparse_nums;     // numbers beyond `dense_limit`
+    std::unordered_map<std::uint64_t, std::int32_t> _by_id;
+    std::vector<mask> _occupied;                            // numbers in use, by output
+
+    /// The numbers in use on the output `idx`, even beyond the ones with a workspace
+    [[nodiscard]]
+    auto occupied_on(int idx) const noexcept
+        -> mask
+    {
+        return idx >= 0 and idx < std::ssize(_occupied) ? _occupied[static_cast<std::size_t>(idx)] : mask{0};
+    }
+
+    /// The free numbers of output `idx` that are not greater than `max_ws`
+    [[nodiscard]]
+    auto free_on(int idx, int max_ws) const noexcept
+        -> mask
+    {
+        auto const available = std::clamp(max_ws - idx * per_output, 0, per_output);
+        return static_cast<mask>(~occupied_on(idx) & ((1u << available) - 1));
+    }
+
+    /// The lowest free number between `from` and `max_ws`
+    [[nodiscard]]
+    auto free_from(int from, int max_ws) const noexcept
+        -> tl::optional<int>
+    {
+        auto const first = (from - 1) / per_output;
+        for (auto idx = first; idx * per_output < max_ws; ++idx) {
+            auto free = free_on(idx, max_ws);
+            if (idx == first) {
+                free = static_cast<mask>(free & (all_free << ((from - 1) % per_output)));
+            }
+            if (free != 0) {
+                return idx * per_output + std::countr_zero(free) + 1;
+            }
+        }
+        return tl::nullopt;
+    }
+
+    /// The highest free number between 1 and `until`
+    [[nodiscard]]
+    auto free_until(int until, int max_ws) const noexcept
+        -> tl::optional<int>
+    {
+        auto const last = (until - 1) / per_output;
+        for (auto idx = last; idx >= 0; --idx) {
+            auto free = free_on(idx, max_ws);
+            if (idx == last) {
+                free = static_cast<mask>(free & ((2u << ((until - 1) % per_output)) - 1));
+            }
+            if (free != 0) {
+                return idx * per_output + std::bit_width(free);
+            }
+        }
+        return tl::nullopt;
+    }
+
+public:
+    /**
+     * Builds the index with a single pass over the workspaces
+     * */
+    explicit workspace_index(std::span<workspace const> workspaces)
+        : _workspaces{workspaces}
+    {
+        auto span = trace::span{"build_workspace_index", "tree"};
+        _by_id.reserve(workspaces.size());
+        for (auto pos = std::int32_t{0}; auto const & ws : workspaces) {
+            _by_id.emplace(ws.id, pos);
+            if (ws.num.has_value() and *ws.num > 0) {
+                auto const num = *ws.num;
+                if (num <= dense_limit) {
+                    if (std::ssize(_by_num) <= num) {
+                        _by_num.resize(static_cast<std::size_t>(num) + 1, none);
+                    }
+                    // As a linear search would, the first workspace with a number wins
+                    auto & slot = _by_num[static_cast<std::size_t>(num)];
+                    slot = slot == none ? pos : slot;
+                }
+                else {
+                    _sparse_nums.emplace(num, pos);
+                }
+                occupy(num);
+            }
+            ++pos;
+        }
+        span.arg("workspaces", workspaces.size());
+    }
+
+    [[nodiscard]] auto size() const noexcept { return _workspaces.size(); }
+    [[nodiscard]] auto workspaces() const noexcept { return _workspaces; }
+
+    /**
+     * Search a workspace by its number, in constant time
+     * */
+    [[nodiscard]]
+    auto find(int num) const
+        -> tl::optional<workspace const &>
+    {
+        auto pos = none;
+        if (num > 0 and num < std::ssize(_by_num)) {
+            pos = _by_num[static_cast<std::size_t>(num)];
+        }
+        else if (auto const found = _sparse_nums.find(num); found != _sparse_nums.end()) {
+            pos = found->second;
+        }
+        if (pos == none) {
+            return tl::nullopt;
+        }
+        return _workspaces[static_cast<std::size_t>(pos)];
+    }
+
+    /**
+     * Search a workspace by the id of its node, in constant time
+     * */
+    [[nodiscard]]
+    auto find_id(std::uint64_t id) const
+        -> tl::optional<workspace const &>
+    {
+        auto const found = _by_id.find(id);
+        if (found == _by_id.end()) {
+            return tl::nullopt;
+        }
+        return _workspaces[static_cast<std::size_t>(found->second)];
+    }
+
+    /// Check if a workspace has the number `num`, or it was marked as used with `occupy`
+    [[nodiscard]]
+    bool is_taken(int num) const noexcept
+    {
+        if (num <= 0) {
+            return false;
+        }
+        if (num > dense_limit) {
+            return _sparse_nums.contains(num);
+        }
+        return (occupied_on((num - 1) / per_output) >> ((num - 1) % per_output) & 1u) != 0;
+    }
+
+    /**
+     * The numbers in use among the ones belonging to output `idx`: bit i stands for the number
+     * `idx * 10 + i + 1`
+     * */
+    [[nodiscard]]
+    auto occupied(int idx) const noexcept
+        -> mask
+    {
+        return occupied_on(idx);
+    }
+
+    /**
+     * Marks a number as used, e.g. because a workspace is going to be renamed to it.
+     *
+     * Only the free numbers are affected: `find` still sees the workspaces as they were.
+     * */
+    void occupy(int num)
+    {
+        if (num <= 0 or num > dense_limit) {
+            return;
+        }
+        auto const idx = static_cast<std::size_t>((num - 1) / per_output);
+        if (_occupied.size() <= idx) {
+            _occupied.resize(idx + 1, mask{0});
+        }
+        _occupied[idx] = static_cast<mask>(_occupied[idx] | (1u << ((num - 1) % per_output)));
+    }
+
+    /**
+     * Search the free number nearest to `base`, between `min_ws` and `max_ws`, preferring the
+     * higher one when two are at the same distance
+     *
+     * \returns The number, or an empty optional if they are all taken
+     * */
+    [[nodiscard]]
+    auto nearest_free(int base, int max_ws, int min_ws = 1) const noexcept
+        -> tl::optional<int>
+    {
+        max_ws = std::min(max_ws, dense_limit);
+        min_ws = std::max(min_ws, 1);
+        if (max_ws < min_ws) {
+            return tl::nullopt;
+        }
+        base = std::clamp(base, min_ws, max_ws);
+        auto const above = free_from(base, max_ws);
+        auto below = free_until(base, max_ws);
+        if (below.has_value() and *below < min_ws) {
+            below = tl::nullopt;
+        }
+        if (not above.has_value() or not below.has_value()) {
+            return above.has_value() ? above : below;
+        }
+        return *above - base <= base - *below ? above : below;
+    }
+};
+
+} // namespace brun
+
+#endif /* WORKSPACE_INDEX_HPP */
@@ -0,0 +1,172 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : workspace_plan
+ * @created     : Saturday Oct 17, 2026 09:12:48 CEST
+ * @description : Computes all the changes needed to put the workspaces in place, and applies them at once
+ * */
+
+#ifndef WORKSPACE_PLAN_HPP
+#define WORKSPACE_PLAN_HPP
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <tl/optional.hpp>
+
+#include "command_batch.hpp"
+#include "context.hpp"
+#include "output_topology.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+#include "workspace_index.hpp"
+
+namespace brun
+{
+
+/**
+ * A workspace whose number is too high for the outputs, and the number it gets instead
+ * */
+struct workspace_rename
+{
+    std::string from;   // the current name
+    std::string to;     // the same name, with the new number
+    int from_num;
+    int to_num;
+};
+
+/**
+ * A workspace on the wrong output
+ * */
+struct workspace_move
+{
+    std::string name;   // after the renames
+    int num;
+    std::string from;
+    std::string to;
+};
+
+/**
+ * The changes that put each workspace on the output matching its number: workspace N belongs to
+ * the output (N - 1) / 10, counting the active outputs in the order of `output_topology`.
+ * */
+struct workspace_plan
+{
+    std::vector<workspace_rename> renames;
+    std::vector<workspace_move> moves;
+
+    [[nodiscard]] bool empty() const noexcept { return renames.empty() and moves.empty(); }
+
+    /// The commands applying the plan, renames first
+    [[nodiscard]]
+    auto commands() const
+        -> command_batch
+    {
+        auto batch = command_batch{};
+        for (auto const & rename : renames) {
+            batch.add("rename workspace {} to {}", quote(rename.from), quote(rename.to));
+        }
+        for (auto const & move : moves) {
+            batch.add("[workspace={}] move workspace to output {}", exact_match(move.name), quote(move.to));
+        }
+        return batch;
+    }
+};
+
+namespace detail
+{
+/// Replaces the number at the beginning of `name` (e.g. "15:web") with `num`
+[[nodiscard]] inline
+auto renumbered(std::string_view name, int num)
+    -> std::string
+{
+    auto const digits = std::min(name.find_first_not_of("0123456789"), name.size());
+    return fmt::format("{}{}", num, name.substr(digits));
+}
+} // namespace detail
+
+
+/**
+ * Computes the renames and the moves needed to put every workspace in place.
+ *
+ * A workspace whose number is beyond the last output is renumbered first, to the same position on
+ * the last output if it is free (e.g. 25 becomes 15 with two outputs), otherwise to the nearest free
+ * number; if there is none it is left as it is. Workspaces without a number, or on an output without
+ * a name, are never touched.
+ * \param workspaces The workspaces, as returned by GET_WORKSPACES
+ * \param topology The active outputs
+ * \returns The plan; applying it to the same state makes the next plan empty
+ * */
+[[nodiscard]] inline
+auto plan_workspaces(std::span<i3_containers::workspace const> workspaces, output_topology const & topology)
+    -> workspace_plan
+{
+    auto const span = trace::span{"plan_workspaces", "tree"};
+    auto plan = workspace_plan{};
+    auto const max_ws = topology.max_workspace();
+    if (max_ws == 0) {
+        return plan;
+    }
+
+    auto taken = workspace_index{workspaces};
+
+    for (auto const & ws : workspaces) {
+        if (not ws.num.has_value() or *ws.num <= 0) {
+            continue;
+        }
+        auto num = *ws.num;
+        auto name = ws.name;
+        if (num > max_ws) {
+            auto const free = taken.nearest_free(max_ws - 10 + (num - 1) % 10 + 1, max_ws);
+            if (not free.has_value()) {
+                brun::log("No free number for workspace {}\n", ws.name);
+                continue;
+            }
+            // `num` is beyond the outputs, and never a candidate: there is no need to free it
+            taken.occupy(*free);
+            name = detail::renumbered(ws.name, *free);
+            plan.renames.push_back({ws.name, name, num, *free});
+            num = *free;
+        }
+
+        if (ws.output.empty()) {
+            continue;
+        }
+        auto const & target = topology.name(*topology.output_of(num));
+        if (ws.output != target) {
+            plan.moves.push_back({std::move(name), num, ws.output, target});
+        }
+    }
+    return plan;
+}
+
+/**
+ * Computes the plan for the current state, with one GET_WORKSPACES and one GET_OUTPUTS
+ * */
+[[nodiscard]] inline
+auto plan_workspaces(context const & ctx)
+    -> workspace_plan
+{
+    return plan_workspaces(ctx.workspaces(), ctx.output_topology());
+}
+
+/**
+ * Applies the whole plan with a single command message
+ *
+ * \returns `true` if every command succeeded
+ * */
+inline
+bool apply(context const & ctx, workspace_plan const & plan)
+{
+    if (plan.empty()) {
+        return true;
+    }
+    return static_cast<bool>(ctx.execute(plan.commands()));
+}
+
+} // namespace brun
+
+#endif /* WORKSPACE_PLAN_HPP */
@@ -13,7 +13,11 @@
 #include <tl/optional.hpp>
 #include <i3-ipc++/i3_ipc.hpp>
 
+#include "context.hpp"
 #include "detail/lippincott.hpp"
+#include "snapshot.hpp"
+#include "tree_range.hpp"
+#include "utils.hpp"
 
 namespace brun
 {
@@ -21,14 +25,14 @@ namespace brun
 /**
  * Search for the focused workspace
  *
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \returns An optional containing the focused workspace, or an empty optional if it was not found
  * */
 [[nodiscard]] inline
-auto focused_workspace(i3_ipc const & i3)
+auto focused_workspace(context const & ctx)
     -> tl::optional<i3_containers::workspace>
 try {
-    auto const workspaces = i3.get_workspaces();
+    auto const & workspaces = ctx.workspaces();
     auto const found = std::ranges::find_if(workspaces, &i3_containers::workspace::is_focused);
     if (found != std::ranges::end(workspaces)) {
         return *found;
@@ -42,15 +46,15 @@ catch (std::exception const & exc) {
 /**
  * Returns the currently focused workspace index
  *
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \returns An optional containing the focused workspace's index, or an empty optional if it
  *          was not found
  * */
 [[nodiscard]] inline
-auto focused_workspace_idx(i3_ipc const & i3)
+auto focused_workspace_idx(context const & ctx)
     -> tl::optional<int>
 try {
-    return focused_workspace(i3).and_then([](auto ws) {
+    return focused_workspace(ctx).and_then([](auto ws) {
         return ws.num.has_value() ? tl::optional{*ws.num} : tl::nullopt;
     });
 }
@@ -62,16 +66,17 @@ catch (std::exception const & exc) {
 /**
  * Returns the first visible but unfocused workspace
  *
- * Note: this function currently only supports two monitors
- * \param i3 The current i3 instance
+ * Note: this function currently only supports two monitors; with more of them, the workspace
+ * visible on each output is given by `output_topology::visible_workspace`
+ * \param ctx The current context
  * \returns An optional containing the visible but unfocused workspace, or an empty optional if it
  *          was found
  * */
 [[nodiscard]] inline
-auto other_workspace(i3_ipc const & i3)
+auto other_workspace(context const & ctx)
     -> tl::optional<i3_containers::workspace>
 try {
-    auto const workspaces = i3.get_workspaces();
+    auto const & workspaces = ctx.workspaces();
     auto condition = [](auto && ws) {
         return ws.is_visible and not ws.is_focused;
     };
@@ -89,15 +94,15 @@ catch (std::exception const & exc) {
  * Returns the index of the first visible but unfocused workspace
  *
  * Note: this function currently only supports two monitors
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \returns An optional containing the visible but unfocused workspace's index, or an empty optional
  *          if it was not found
  * */
 [[nodiscard]] inline
-auto other_workspace_idx(i3_ipc const & i3)
+auto other_workspace_idx(context const & ctx)
     -> tl::optional<int>
 try {
-    return other_workspace(i3).and_then([](auto ws) {
+    return other_workspace(ctx).and_then([](auto ws) {
         return ws.num.has_value() ? tl::optional{*ws.num} : tl::nullopt;
     });
 }
@@ -108,107 +113,181 @@ catch (std::exception const & exc) {
 /**
  * Returns the node of the tree representing the requested workspace
  *
- * \param i3 The current i3 instance
+ * \param root The root of the tree
  * \param idx The workspace index
  * \returns An optional containing the node of the requested workspace
  * */
 [[nodiscard]] inline
-auto get_workspace_node(i3_ipc const & i3, uint64_t id)
-    -> tl::optional<i3_containers::node>
+auto get_workspace_node(i3_containers::node const & root, uint64_t id)
+    -> tl::optional<i3_containers::node const &>
 {
-    auto nodes = std::queue<i3_containers::node>{};
-    nodes.push(i3.get_tree());
+    // The workspaces are near the root, and the visit stops at the first one with the id
+    auto nodes = breadth_first(root);
+    auto const found = std::ranges::find_if(nodes, [id](auto const & node) {
+        return node.id == id and node.type == i3_containers::node_type::workspace;
+    });
+    if (found == nodes.end()) {
+        return tl::nullopt;
+    }
+    return *found;
+}
 
-    while (not nodes.empty()) {
-        auto node = std::move(nodes.front());
-        nodes.pop();
+/**
+ * Returns the node of the snapshot representing the requested workspace
+ *
+ * \param tree The snapshot of the tree
+ * \param idx The workspace index
+ * \returns An optional containing the node of the requested workspace
+ * */
+[[nodiscard]] inline
+auto get_workspace_node(snapshot const & tree, uint64_t id)
+    -> tl::optional<snapshot::node_ref>
+{
+    return tree.find(id).and_then([](auto node) {
+        return node.type() == i3_containers::node_type::workspace ? tl::optional{node} : tl::nullopt;
+    });
+}
 
-        if (node.type == i3_containers::node_type::workspace) {
-            if (node.id == id) {
-                return node;
-            }
-            continue;
-        }
-        for (auto const & subnode : node.nodes) {
-            nodes.push(subnode);
-        }
-    }
-    return tl::nullopt;
+/**
+ * Returns the node of the tree representing the requested workspace
+ *
+ * \param ctx The current context
+ * \param idx The workspace index
+ * \returns An optional containing the node of the requested workspace
+ * */
+[[nodiscard]] inline
+auto get_workspace_node(context const & ctx, uint64_t id)
+    -> tl::optional<snapshot::node_ref>
+{
+    return get_workspace_node(ctx.flat_tree(), id);
 }
 
 /**
  * Find the workspace given its node id
  *
- * \param i3 The current i3 instance
+ * \param ctx The current context
  * \param idx The workspace index
  * \returns An optional containing the required workspace
  * */
 [[nodiscard]] inline
-auto get_workspace_from_node_id(i3_ipc const & i3, uint64_t id)
+auto get_workspace_from_node_id(context const & ctx, uint64_t id)
     -> tl::optional<i3_containers::workspace>
 {
-    auto const workspaces = i3.get_workspaces();
-    for (auto const & ws : workspaces) {
-        if (ws.id == id) {
-            return ws;
-        }
-    }
-    return tl::nullopt;
+    return ctx.workspaces_index().find_id(id)
+        .transform([](auto const & ws) { return ws; });
 }
 
 
 namespace detail
 {
-struct recursive_result
-{
-    bool found;
-    std::optional<i3_containers::node> workspace_id;
-};
-
+/// \exclude
 [[nodiscard]] inline
 auto find_ws_by_mark_impl(i3_containers::node const & root, std::string_view const mark)
-    -> recursive_result
+    -> tl::optional<i3_containers::node const &>
 {
-    if (std::ranges::find(root.marks, mark) != root.marks.end()) {
-        if (root.type == i3_containers::node_type::workspace) {
-            return { true, root };
+    auto const is_marked = with_mark(mark);
+    for (auto it = preorder(root).begin(); it != std::default_sentinel; ++it) {
+        if (not is_marked(*it)) {
+            continue;
         }
-        return { true, std::nullopt };
-    }
-
-    for (auto const & node : root.nodes) {
-        auto [found, the_node] = find_ws_by_mark_impl(node, mark);
-        if (found) {
-            if (the_node.has_value()) {
-                return { true, std::move(the_node) };
-            }
-            if (root.type == i3_containers::node_type::workspace) {
-                return { true, root };
-            }
-            return { true, std::nullopt };
+        // The nearest workspace enclosing the marked container, or the container itself
+        auto const enclosing = it.path() | std::views::reverse;
+        auto const ws = std::ranges::find_if(enclosing, of_type(i3_containers::node_type::workspace));
+        if (ws == enclosing.end()) {
+            return tl::nullopt;
         }
+        return *ws;
     }
+    return tl::nullopt;
+}
 
-    return { false, std::nullopt };
+/// \exclude
+[[nodiscard]] inline
+auto find_ws_by_mark_impl(snapshot const & tree, std::string_view const mark)
+    -> tl::optional<snapshot::node_ref>
+{
+    auto node = tree.find_mark(mark);
+    while (node.has_value() and node->type() != i3_containers::node_type::workspace) {
+        node = node->parent();
+    }
+    return node;
 }
 }  // namespace detail
 
+[[nodiscard]] inline
+auto find_ws_by_mark(snapshot const & tree, std::string_view const mark)
+    -> tl::optional<snapshot::node_ref>
+{
+    return detail::find_ws_by_mark_impl(tree, mark);
+}
+
 [[nodiscard]] inline
 auto find_ws_by_mark(i3_containers::node const & root, std::string_view const mark)
-    -> tl::optional<i3_containers::node>
+    -> tl::optional<i3_containers::node const &>
+{
+    return detail::find_ws_by_mark_impl(root, mark);
+}
+
+[[nodiscard]] inline
+auto find_ws_by_mark(context const & ctx, std::string_view const mark)
+    -> tl::optional<snapshot::node_ref>
 {
-    auto [found, node] = detail::find_ws_by_mark_impl(root, mark);
-    if (found) {
-        return { node.value() };
+    return find_ws_by_mark(ctx.flat_tree(), mark);
+}
+
+/**
+ * Interprets a command line argument as a workspace
+ *
+ * The argument can either be the number of a workspace or a mark, optionally prefixed by "mark:";
+ * in the latter case the number of the workspace containing the marked container is returned,
+ * looking it up in the mark index.
+ * \param ctx The current context
+ * \param arg The argument to be interpreted
+ * \returns An optional containing the number of the workspace, or an empty optional if `arg` is
+ *          neither a number nor an existing mark
+ * */
+[[nodiscard]] inline
+auto target_workspace(context const & ctx, std::string_view arg)
+    -> tl::optional<int>
+{
+    // If it's a number, all good
+    if (auto const n = brun::stoi(arg); n.has_value()) {
+        return n;
     }
-    return tl::nullopt;
+    // If it does start with "mark:", erase that part
+    if (arg.starts_with("mark:")) {
+        arg.remove_prefix(5);
+    }
+    // Check if it effectively is a mark
+    auto const location = ctx.marks_index().find(arg);
+    if (not location.has_value()) {
+        fmt::print(stderr, "Argument passed ({}) is not a number nor a mark\n", arg);
+        return tl::nullopt;
+    }
+    return location->workspace_num;
 }
 
+/**
+ * Interprets a command line argument as a mark, optionally prefixed by "mark:"
+ *
+ * \param ctx The current context
+ * \param arg The argument to be interpreted
+ * \returns An optional containing the id of the marked container, or an empty optional if `arg`
+ *          is not an existing mark
+ * */
 [[nodiscard]] inline
-auto find_ws_by_mark(i3_ipc const & i3, std::string_view const mark)
-    -> tl::optional<i3_containers::node>
+auto target_container(context const & ctx, std::string_view arg)
+    -> tl::optional<uint64_t>
 {
-    return find_ws_by_mark(i3.get_tree(), mark);
+    if (arg.starts_with("mark:")) {
+        arg.remove_prefix(5);
+    }
+    auto const location = ctx.marks_index().find(arg);
+    if (not location.has_value()) {
+        fmt::print(stderr, "Argument passed ({}) is not a mark\n", arg);
+        return tl::nullopt;
+    }
+    return location->container;
 }
 
 } // namespace brun
@@ -5,18 +5,19 @@
  * @description : move each workspace in an output depending on its index
  */
 
+#include <cstdlib>
 #include <i3-ipc++/i3_ipc.hpp>
-#include <fmt/core.h>
 
-#include "workspaces.hpp"
-#include "workspace_extra.hpp"
-#include "utils.hpp"
+#include "context.hpp"
+#include "daemon.hpp"
+#include "tools/fix_workspaces.hpp"
 
-int main()
+int main(int argc, char const * argv[])
 {
-    auto const i3 = i3_ipc{std::getenv("I3SOCK")};
-
-    auto const workspaces = i3.get_workspaces();
-    auto const fix_ws = [&i3](auto ws_idx) { brun::fix_ws_output(i3, ws_idx.value()); };
-    std::ranges::for_each(workspaces, fix_ws, &i3_containers::workspace::num);
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    if (auto const status = brun::daemon::forward("fix_workspaces", args); status.has_value()) {
+        return *status;
+    }
+    auto i3 = brun::connect();
+    return brun::tools::fix_workspaces(brun::context{i3}, args);
 }
@@ -0,0 +1,72 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : i3_tools
+ * @created     : Saturday Oct 17, 2026 01:02:37 CEST
+ * @description : all the tools in a single binary, chosen by the name it is invoked with
+ */
+
+#include <cstdlib>
+#include <span>
+#include <string_view>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+
+#include "context.hpp"
+#include "daemon.hpp"
+#include "shared_state.hpp"
+#include "tools.hpp"
+
+namespace
+{
+[[nodiscard]]
+auto basename(std::string_view path)
+    -> std::string_view
+{
+    auto const slash = path.rfind('/');
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+int usage(std::string_view name)
+{
+    fmt::print(stderr, "Usage: {} <tool> [args...]\nTools:", name);
+    for (auto const & tool : brun::tools::all) {
+        fmt::print(stderr, " {}", tool.name);
+    }
+    fmt::print(stderr, "\n");
+    return 1;
+}
+} // namespace
+
+// Invoked through a symlink named as a tool (`focus_window left`) it runs that tool; otherwise
+//  the tool is the first argument (`i3_tools focus_window left`). Either way the tool sees the
+//  same `argv` it would have as a separate executable.
+int main(int argc, char const * argv[])
+{
+    auto args = std::span{argv, static_cast<std::size_t>(argc)};
+    auto const * tool = args.empty() ? nullptr : brun::tools::find(basename(args[0]));
+    if (tool == nullptr) {
+        if (args.size() < 2) {
+            return usage(args.empty() ? "i3_tools" : args[0]);
+        }
+        tool = brun::tools::find(args[1]);
+        if (tool == nullptr) {
+            return usage(args[0]);
+        }
+        args = args.subspan(1);
+    }
+
+    // Nothing but the dispatch runs before this point, so that a request served by the daemon
+    //  does not pay for the connection to i3; the published state spares the request too
+    if (tool->reads_shared_state) {
+        if (auto const status = brun::shared_state::run(tool->run, args); status.has_value()) {
+            return *status;
+        }
+    }
+    if (brun::tools::served_by_daemon(*tool, args)) {
+        if (auto const status = brun::daemon::forward(tool->name, args); status.has_value()) {
+            return *status;
+        }
+    }
+    auto i3 = brun::connect();
+    return tool->run(brun::context{i3}, args);
+}
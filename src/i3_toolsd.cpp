@@ -0,0 +1,339 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : i3_toolsd
+ * @created     : Friday Oct 16, 2026 11:58:27 CEST
+ * @description : daemon which keeps a connection to i3 open and runs the tools on behalf of their clients
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <i3-ipc++/i3_ipc.hpp>
+#include <fmt/core.h>
+#include <tl/optional.hpp>
+
+#include "command_batch.hpp"
+#include "context.hpp"
+#include "daemon.hpp"
+#include "event_loop.hpp"
+#include "ipc.hpp"
+#include "output_topology.hpp"
+#include "placement_queue.hpp"
+#include "shared_state.hpp"
+#include "snapshot.hpp"
+#include "tools.hpp"
+#include "trace.hpp"
+#include "tree_diff.hpp"
+#include "tree_mirror.hpp"
+#include "utils.hpp"
+#include "detail/i3_json.hpp"
+#include "detail/lippincott.hpp"
+
+namespace
+{
+/// How long a request waits for the events of the previous commands, before fetching the tree
+constexpr auto settle_timeout = std::chrono::milliseconds{100};
+
+/// The loop of the daemon, stopped by SIGTERM and SIGINT so that the daemon withdraws the state
+brun::event_loop * running_loop = nullptr;
+
+void stop_running_loop(int /* signal */)
+{
+    running_loop->stop();
+}
+} // namespace
+
+int main()
+try {
+    // The only connection for requests and commands: the contexts of the requests share it, so
+    //  that serving a request never connects to i3
+    auto i3 = brun::connect();
+    auto server = brun::daemon::server{brun::daemon::socket_path()};
+    // The state read by the tools that do not need to ask anything, if it can be published
+    auto shared = tl::optional<brun::shared_state::publisher>{};
+    if (auto path = brun::shared_state::path(); not path.empty()) {
+        try {
+            shared.emplace(std::move(path));
+        }
+        catch (std::exception const & exc) {
+            brun::log("Not publishing the state: {}\n", exc.what());
+        }
+    }
+
+    // The mirror and the launches of exec are shared by the event loop, which patches the mirror
+    //  and places the new windows, and by the worker, which runs the tools
+    auto mutex = std::mutex{};
+    auto mirror = brun::tree_mirror{brun::get_tree(i3)};
+    auto placements = brun::placement_queue{};
+    // Built again only after an output event; the visible workspaces are read from the mirror
+    auto topology = tl::optional<brun::output_topology>{};
+    // Only used to send the commands placing the windows
+    auto const placer = brun::context{i3};
+
+    // Events are received on their own connection; when i3 exits or restarts the connection is
+    //  lost and the daemon quits, so that the clients fall back to talk with i3 directly
+    auto events = brun::ipc::connection{};
+    events.subscribe(R"(["window","workspace","output","shutdown","tick"])");
+    // Anything that happened before the subscription was lost
+    mirror.invalidate();
+    // Only what happens from now on is known, apart from the workspaces visible now
+    auto history = brun::workspace_history{brun::get_workspaces(i3)};
+
+    // The events of the commands sent by the daemon are applied to the mirror as any other, but
+    //  the mirror reflects the commands only once all of them arrived: after the commands a tick is
+    //  sent, and i3 sends it back to the subscribers after the events of the commands
+    auto ticks_sent = std::uint64_t{0};
+    auto ticks_seen = std::uint64_t{0};
+    auto settled = std::condition_variable{};
+    auto const tick_payload = [pid = ::getpid()](std::uint64_t tick) { return fmt::format("i3_toolsd {} {}", pid, tick); };
+    // To be called with the mutex held, after executing some commands
+    auto const await_events = [&] {
+        (void)i3.request_view(brun::ipc::message_type::send_tick, tick_payload(++ticks_sent));
+    };
+    auto const has_pending_events = [&] { return ticks_seen != ticks_sent; };
+
+    // Brings the mirror and the topology up to date; to be called with the mutex held
+    auto const sync = [&] {
+        mirror.sync(i3);
+        if (not topology.has_value()) {
+            topology.emplace(brun::get_outputs(i3));
+        }
+        topology->update_visible(mirror.tree());
+    };
+    // Publishes the state of the mirror; to be called with the mutex held.
+    // After the commands of a tool reading the state the tree is fetched again, since their events
+    //  could be still on their way: with `fetch` it is done right away, otherwise the state is only
+    //  withdrawn, and `false` returned.
+    auto const publish = [&](bool fetch) {
+        if (not shared.has_value()) {
+            return true;
+        }
+        // Read before fetching the tree, which then reflects all the commands counted so far
+        auto const commands = shared->commands();
+        if (commands != shared->commands_seen()) {
+            mirror.invalidate();
+        }
+        // Published again when the tick arrives
+        if (has_pending_events()) {
+            shared->withdraw();
+            return false;
+        }
+        if (fetch) {
+            sync();
+        }
+        if (mirror.needs_resync() or not topology.has_value()) {
+            shared->withdraw();
+            return false;
+        }
+        topology->update_visible(mirror.tree());
+        shared->publish(mirror.tree(), mirror.marks(), *topology, commands);
+        return true;
+    };
+
+    // With I3_TOOLSD_VERIFY the patched mirror is compared with the tree of i3 after each event, to
+    //  find the patches which do not do what i3 does; to be called with the mutex held
+    auto const verify = [&, enabled = std::getenv("I3_TOOLSD_VERIFY") != nullptr] {
+        // In a burst of events only the last one is checked, when the mirror has caught up with i3
+        if (not enabled or mirror.needs_resync() or events.has_message()) {
+            return;
+        }
+        auto const patched = brun::snapshot{mirror.tree()};
+        auto const fetched = brun::snapshot::decode(i3.request_view(brun::ipc::message_type::get_tree));
+        // i3 sends the events of a change before answering the following requests: if none came
+        //  meanwhile, the fetched tree is the one described by the events applied so far
+        if (events.has_message()) {
+            return;
+        }
+        auto changes = brun::diff(patched, fetched);
+        // The rects resized as a side effect of a change are not in the events
+        std::erase_if(changes, [](auto const & change) { return change.kind == brun::tree_change_kind::rect; });
+        if (not changes.empty()) {
+            fmt::print(stderr, "The mirror differs from i3 in {} changes\n", changes.size());
+        }
+        for (auto const & change : changes) {
+            fmt::print(stderr, "  {}\n", brun::describe(change));
+        }
+    };
+
+    auto loop = brun::event_loop{};
+    running_loop = &loop;
+    std::signal(SIGTERM, stop_running_loop);
+    std::signal(SIGINT, stop_running_loop);
+    // The tools write to the stdout and the stderr of the clients, which could be pipes whose
+    //  reader is gone: the write fails instead of killing the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+    // Fetches the state that could not be published, once the events stop coming for a while
+    brun::timer resync{loop, [&mutex, &publish, &resync] {
+        auto const lock = std::scoped_lock{mutex};
+        if (not publish(true)) {
+            resync.arm(brun::shared_state::resync_delay);
+        }
+    }};
+    auto const republish = [&publish, &resync] {
+        if (not publish(false) and not resync.armed()) {
+            resync.arm(brun::shared_state::resync_delay);
+        }
+    };
+    brun::timer expiry{loop, [&mutex, &placements, &placer, &expiry, &await_events] {
+        auto const lock = std::scoped_lock{mutex};
+        auto batch = brun::command_batch{};
+        for (auto const & abandoned : placements.expire(std::chrono::steady_clock::now())) {
+            brun::log("No window for {}\n", abandoned.program);
+            brun::abandon(batch, abandoned);
+        }
+        if (not batch.empty()) {
+            placer.execute(batch);
+            await_events();
+        }
+        if (auto const next = placements.next_deadline(); next.has_value()) {
+            expiry.arm(*next);
+        }
+    }};
+
+    auto message = brun::ipc::message{};
+    loop.watch(events.fd(), [&] {
+        events.receive(message);
+        if (not message.is_event()) {
+            return;
+        }
+        auto json = brun::json::reader{message.payload};
+        auto const lock = std::scoped_lock{mutex};
+        switch (message.event()) {
+        case brun::ipc::event_type::window: {
+            auto const event = brun::json::read_window_event(json);
+            brun::log("Window event on container {}\n", event.container.id);
+            mirror.apply(event, brun::read_container_placement(message.payload));
+            if (event.change != i3_containers::window_change::create or placements.empty()) {
+                break;
+            }
+            auto const window = brun::read_window_identity(message.payload);
+            if (auto const matched = placements.match(window); matched.has_value()) {
+                auto batch = brun::command_batch{};
+                brun::place(batch, *matched, window.id);
+                placer.execute(batch);
+                await_events();
+            }
+            break;
+        }
+        case brun::ipc::event_type::workspace:
+            brun::log("Workspace event\n");
+            mirror.apply(brun::json::read_workspace_event(json));
+            history.apply(message.payload);
+            break;
+        case brun::ipc::event_type::output:
+            brun::log("Output event\n");
+            mirror.apply(i3_containers::output_event{i3_containers::output_change::unspecified});
+            topology.reset();
+            break;
+        case brun::ipc::event_type::tick:
+            // Only the last tick sent matters: the events of all the commands before it arrived
+            json.begin_object();
+            while (auto const key = json.next_key()) {
+                if (*key != "payload") {
+                    json.skip_value();
+                }
+                else if (json.read_string() == tick_payload(ticks_sent)) {
+                    ticks_seen = ticks_sent;
+                    settled.notify_all();
+                }
+            }
+            break;
+        case brun::ipc::event_type::shutdown:
+            brun::log("i3 is shutting down\n");
+            loop.stop();
+            return;
+        default:
+            break;
+        }
+        verify();
+        republish();
+    });
+    {
+        auto const lock = std::scoped_lock{mutex};
+        republish();
+    }
+
+    // Waits for the events of the last commands, and brings the mirror up to date; in the unlikely
+    //  case that they do not arrive, the tree is fetched again
+    auto const settle = [&](std::unique_lock<std::mutex> & lock) {
+        if (not settled.wait_for(lock, settle_timeout, [&] { return not has_pending_events(); })) {
+            brun::log("No tick from i3 after {} ms\n", settle_timeout.count());
+            ticks_seen = ticks_sent;
+            mirror.invalidate();
+        }
+        sync();
+    };
+
+    auto worker = std::jthread{[&] {
+        server.serve([&](brun::daemon::request const & req) -> int {
+            // exec does not wait for the window here: the launch is queued, and the event loop
+            //  places the window when it appears
+            if (req.tool == "exec") {
+                auto const request = brun::tools::detail::parse_exec_args(req.args);
+                if (not request.has_value()) {
+                    return brun::daemon::fallback_status;
+                }
+                auto lock = std::unique_lock{mutex};
+                settle(lock);
+                auto const ctx = brun::context{i3, mirror.tree(), mirror.marks(), *topology};
+                auto pending = [&] {
+                    auto const output = brun::daemon::client_output{req};
+                    return brun::tools::start_launch(ctx, *request);
+                }();
+                if (pending.has_value()) {
+                    placements.push(std::move(*pending));
+                    expiry.arm(*placements.next_deadline());
+                }
+                if (ctx.has_executed_commands()) {
+                    await_events();
+                }
+                republish();
+                return 0;
+            }
+
+            auto const * tool = brun::tools::find(req.tool);
+            if (tool == nullptr or not brun::tools::served_by_daemon(*tool, req.args)) {
+                brun::log("Tool {} is not served by the daemon\n", req.tool);
+                return brun::daemon::fallback_status;
+            }
+            auto lock = std::unique_lock{mutex};
+            settle(lock);
+            auto ctx = brun::context{i3, mirror.tree(), mirror.marks(), *topology};
+            ctx.set_history(history);
+            // The events of the commands are applied by the event loop, which needs the mutex
+            ctx.set_watched();
+            // Only the tool writes to the client: the event loop writes while holding the mutex
+            auto const status = [&] {
+                auto const output = brun::daemon::client_output{req};
+                return tool->run(ctx, req.args);
+            }();
+            // The events caused by the commands could still be on their way, and the next request
+            //  must not see the tree as it was before them
+            if (ctx.has_executed_commands()) {
+                await_events();
+            }
+            republish();
+            return status;
+        });
+    }};
+
+    try {
+        loop.run();
+    }
+    catch (std::exception const & exc) {
+        brun::log("Lost connection to i3: {}\n", exc.what());
+    }
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGINT, SIG_DFL);
+    // The trace is complete now, even if a second signal cuts the teardown short
+    brun::trace::recorder().flush();
+    server.shutdown();
+}
+catch (std::exception const & exc) {
+    brun::detail::lippincott();
+}
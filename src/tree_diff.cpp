@@ -0,0 +1,75 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : tree_diff
+ * @created     : Saturday Oct 17, 2026 17:20:44 CEST
+ * @description : prints what changed between two dumps of the i3 tree, or between a dump and the current tree
+ */
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fmt/core.h>
+
+#include "ipc.hpp"
+#include "snapshot.hpp"
+#include "tree_diff.hpp"
+
+namespace
+{
+/// The content of a file, or of the standard input for "-"
+auto read_dump(std::string_view path)
+    -> std::string
+{
+    if (path == "-") {
+        return {std::istreambuf_iterator<char>{std::cin}, std::istreambuf_iterator<char>{}};
+    }
+    auto file = std::ifstream{std::string{path}, std::ios::binary};
+    if (not file) {
+        throw std::runtime_error{fmt::format("cannot open {}", path)};
+    }
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+} // namespace
+
+/**
+ * Exits as diff(1) does: 0 if the trees are the same, 1 if they differ, 2 on errors
+ * */
+int main(int argc, char const * argv[])
+try {
+    auto const args = std::span{argv, static_cast<std::size_t>(argc)};
+    if (args.size() != 2 and args.size() != 3) {
+        fmt::print(stderr, "Usage: {} <before.json> [<after.json>]\n"
+                           "Without <after.json>, compares with the current tree; \"-\" reads the standard input\n",
+                   args[0]);
+        return 2;
+    }
+    auto const before = brun::snapshot::decode(read_dump(args[1]));
+    auto const after = args.size() == 3
+        ? brun::snapshot::decode(read_dump(args[2]))
+        : brun::snapshot::decode(brun::ipc::connection{}.request_view(brun::ipc::message_type::get_tree));
+
+    auto const changes = brun::diff(before, after);
+    auto counts = std::array<std::size_t, static_cast<std::size_t>(brun::tree_change_kind::marks) + 1>{};
+    for (auto const & change : changes) {
+        fmt::print("{}\n", brun::describe(change));
+        ++counts[static_cast<std::size_t>(change.kind)];
+    }
+    fmt::print(stderr, "{} containers before, {} after, {} changes", before.size(), after.size(), changes.size());
+    for (auto kind = std::size_t{0}; kind < counts.size(); ++kind) {
+        if (counts[kind] != 0) {
+            fmt::print(stderr, ", {} {}", counts[kind], brun::to_string(static_cast<brun::tree_change_kind>(kind)));
+        }
+    }
+    fmt::print(stderr, "\n");
+    return changes.empty() ? 0 : 1;
+}
+catch (std::exception const & exc) {
+    fmt::print(stderr, "{}\n", exc.what());
+    return 2;
+}